@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the subset of libstratosphere used by the portable mc_mitm core.
+ * Ticks are nanoseconds and the synchronisation primitives are backed by the standard library.
+ */
+#pragma once
+#include <switch.h>
+#include <cstring>
+#include <cstdlib>
+#include <strings.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#define NOINLINE __attribute__((noinline))
+
+#define AMS_CONCATENATE_IMPL(a, b) a##b
+#define AMS_CONCATENATE(a, b) AMS_CONCATENATE_IMPL(a, b)
+
+#define AMS_ABORT() std::abort()
+#define AMS_ABORT_UNLESS(expr) do { if (!(expr)) { AMS_ABORT(); } } while (0)
+#define AMS_ASSERT(expr) AMS_ABORT_UNLESS(expr)
+
+#define R_TRY(res_expr) do { const auto _tmp_r_try_rc = (res_expr); if (R_FAILED(_tmp_r_try_rc)) { return _tmp_r_try_rc; } } while (0)
+#define R_ABORT_UNLESS(res_expr) AMS_ABORT_UNLESS(R_SUCCEEDED(res_expr))
+
+namespace ams::impl {
+
+    template<typename F>
+    class ScopeGuard {
+        public:
+            explicit ScopeGuard(F f) : m_f(std::move(f)) { }
+            ~ScopeGuard(void) { m_f(); }
+
+        private:
+            F m_f;
+    };
+
+    struct ScopeGuardHelper {
+        template<typename F>
+        ScopeGuard<F> operator+(F f) { return ScopeGuard<F>(std::move(f)); }
+    };
+
+}
+
+#define ON_SCOPE_EXIT auto AMS_CONCATENATE(scope_exit_guard_, __LINE__) = ::ams::impl::ScopeGuardHelper() + [&]()
+
+namespace ams {
+
+    constexpr inline Result ResultSuccess(void) {
+        return 0;
+    }
+
+    class TimeSpan {
+        public:
+            constexpr TimeSpan(void) : m_ns(0) { }
+
+            static constexpr TimeSpan FromNanoSeconds(s64 ns)   { return TimeSpan(ns); }
+            static constexpr TimeSpan FromMicroSeconds(s64 us)  { return TimeSpan(us * INT64_C(1000)); }
+            static constexpr TimeSpan FromMilliSeconds(s64 ms)  { return TimeSpan(ms * INT64_C(1000000)); }
+            static constexpr TimeSpan FromSeconds(s64 s)        { return TimeSpan(s * INT64_C(1000000000)); }
+
+            constexpr s64 GetNanoSeconds(void) const  { return m_ns; }
+            constexpr s64 GetMicroSeconds(void) const { return m_ns / INT64_C(1000); }
+            constexpr s64 GetMilliSeconds(void) const { return m_ns / INT64_C(1000000); }
+            constexpr s64 GetSeconds(void) const      { return m_ns / INT64_C(1000000000); }
+
+            constexpr auto operator<=>(const TimeSpan &) const = default;
+            constexpr TimeSpan operator+(const TimeSpan &rhs) const { return TimeSpan(m_ns + rhs.m_ns); }
+            constexpr TimeSpan operator-(const TimeSpan &rhs) const { return TimeSpan(m_ns - rhs.m_ns); }
+
+        private:
+            constexpr explicit TimeSpan(s64 ns) : m_ns(ns) { }
+
+            s64 m_ns;
+    };
+
+    namespace svc {
+
+        constexpr inline s32 HighestThreadPriority = 0;
+        constexpr inline s32 LowestThreadPriority  = 63;
+
+    }
+
+    namespace util {
+
+        template<char A, char B, char C, char D>
+        struct FourCC {
+            static constexpr u32 Code = (static_cast<u32>(A) << 0) | (static_cast<u32>(B) << 8) | (static_cast<u32>(C) << 16) | (static_cast<u32>(D) << 24);
+        };
+
+        template<typename T>
+        constexpr T SwapBytes(T value) {
+            if constexpr (sizeof(T) == sizeof(u64))
+                return __builtin_bswap64(value);
+            else if constexpr (sizeof(T) == sizeof(u32))
+                return __builtin_bswap32(value);
+            else if constexpr (sizeof(T) == sizeof(u16))
+                return __builtin_bswap16(value);
+            else
+                return value;
+        }
+
+    }
+
+    namespace hos {
+
+        enum Version : u32 {
+            Version_Min = 0,
+            Version_1_0_0,
+            Version_2_0_0,
+            Version_3_0_0,
+            Version_4_0_0,
+            Version_5_0_0,
+            Version_6_0_0,
+            Version_7_0_0,
+            Version_8_0_0,
+            Version_9_0_0,
+            Version_10_0_0,
+            Version_11_0_0,
+            Version_12_0_0,
+            Version_Max,
+        };
+
+        Version GetVersion(void);
+
+    }
+
+    namespace os {
+
+        constexpr inline Result ResultBusy(void) {
+            return 0x803;
+        }
+
+        class Tick {
+            public:
+                constexpr explicit Tick(s64 tick = 0) : m_tick(tick) { }
+
+                constexpr s64 GetInt64Value(void) const { return m_tick; }
+
+                constexpr auto operator<=>(const Tick &) const = default;
+                constexpr Tick operator+(const Tick &rhs) const { return Tick(m_tick + rhs.m_tick); }
+                constexpr Tick operator-(const Tick &rhs) const { return Tick(m_tick - rhs.m_tick); }
+                constexpr Tick &operator+=(const Tick &rhs) { m_tick += rhs.m_tick; return *this; }
+                constexpr Tick &operator-=(const Tick &rhs) { m_tick -= rhs.m_tick; return *this; }
+
+            private:
+                s64 m_tick;
+        };
+
+        Tick GetSystemTick(void);
+        s64 GetSystemTickFrequency(void);
+        TimeSpan ConvertToTimeSpan(Tick tick);
+        Tick ConvertToTick(TimeSpan ts);
+
+        void SleepThread(TimeSpan ts);
+
+        class Mutex {
+            public:
+                explicit Mutex(bool recursive) { (void)recursive; }
+
+                void lock(void)     { m_mutex.lock(); }
+                void unlock(void)   { m_mutex.unlock(); }
+                bool try_lock(void) { return m_mutex.try_lock(); }
+
+            private:
+                std::recursive_mutex m_mutex;
+        };
+
+        class SdkMutex {
+            public:
+                constexpr SdkMutex(void) { }
+
+                void lock(void)     { m_mutex.lock(); }
+                void unlock(void)   { m_mutex.unlock(); }
+                bool try_lock(void) { return m_mutex.try_lock(); }
+
+            private:
+                std::mutex m_mutex;
+        };
+
+        enum EventClearMode {
+            EventClearMode_ManualClear = 0,
+            EventClearMode_AutoClear   = 1,
+        };
+
+        struct EventType {
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool signaled;
+            EventClearMode clear_mode;
+        };
+
+        void InitializeEvent(EventType *event, bool signaled, EventClearMode clear_mode);
+        void FinalizeEvent(EventType *event);
+        void SignalEvent(EventType *event);
+        void WaitEvent(EventType *event);
+        bool TryWaitEvent(EventType *event);
+        bool TimedWaitEvent(EventType *event, TimeSpan timeout);
+        void ClearEvent(EventType *event);
+
+        class Event {
+            public:
+                explicit Event(EventClearMode clear_mode) { InitializeEvent(&m_event, false, clear_mode); }
+
+                void Signal(void)                   { SignalEvent(&m_event); }
+                void Wait(void)                     { WaitEvent(&m_event); }
+                bool TryWait(void)                  { return TryWaitEvent(&m_event); }
+                bool TimedWait(TimeSpan timeout)    { return TimedWaitEvent(&m_event, timeout); }
+                void Clear(void)                    { ClearEvent(&m_event); }
+
+                EventType *GetBase(void) { return &m_event; }
+
+            private:
+                EventType m_event;
+        };
+
+        // There are no kernel handles off-console, so a system event behaves like a regular one
+        class SystemEvent : public Event {
+            public:
+                SystemEvent(void) : Event(EventClearMode_AutoClear) { }
+                SystemEvent(EventClearMode clear_mode, bool inter_process) : Event(clear_mode) { (void)inter_process; }
+        };
+
+        using ThreadId = u64;
+
+    }
+
+    namespace fs {
+
+        struct FileHandle {
+            void *handle;
+        };
+
+        enum OpenMode {
+            OpenMode_Read        = BIT(0),
+            OpenMode_Write       = BIT(1),
+            OpenMode_AllowAppend = BIT(2),
+        };
+
+        struct WriteOption {
+            u32 value;
+
+            static const WriteOption None;
+            static const WriteOption Flush;
+        };
+
+        Result MountSdCard(const char *name);
+        void Unmount(const char *name);
+
+        Result CreateDirectory(const char *path);
+        Result CreateFile(const char *path, s64 size);
+        Result OpenFile(FileHandle *out, const char *path, int mode);
+        void CloseFile(FileHandle handle);
+        Result ReadFile(FileHandle handle, s64 offset, void *buffer, size_t size);
+        Result ReadFile(size_t *out, FileHandle handle, s64 offset, void *buffer, size_t size);
+        Result WriteFile(FileHandle handle, s64 offset, const void *buffer, size_t size, const WriteOption &option);
+        Result GetFileSize(s64 *out, FileHandle handle);
+        Result SetFileSize(FileHandle handle, s64 size);
+
+    }
+
+    namespace util::ini {
+
+        using Handler = int (*)(void *user, const char *section, const char *name, const char *value);
+
+        s32 ParseFile(fs::FileHandle file, void *user_ctx, Handler h);
+
+    }
+
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the subset of libnx used by the portable mc_mitm core.
+ * Only the types and fields the core touches are mirrored here.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+typedef u32 Result;
+typedef u32 Handle;
+
+#define BIT(n) (1U<<(n))
+#define INVALID_HANDLE 0
+
+#define R_SUCCEEDED(res) ((res) == 0)
+#define R_FAILED(res)    ((res) != 0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    u32 session;
+} Service;
+
+typedef enum {
+    Perm_None = 0,
+    Perm_R    = BIT(0),
+    Perm_W    = BIT(1),
+    Perm_Rw   = Perm_R | Perm_W,
+} Permission;
+
+typedef struct {
+    Handle handle;
+    size_t size;
+    Permission perm;
+    void *map_addr;
+} SharedMemory;
+
+Result shmemCreate(SharedMemory *s, size_t size, Permission local_perm, Permission remote_perm);
+void shmemLoadRemote(SharedMemory *s, Handle handle, size_t size, Permission perm);
+Result shmemMap(SharedMemory *s);
+Result shmemUnmap(SharedMemory *s);
+Result shmemClose(SharedMemory *s);
+
+static inline void *shmemGetAddr(SharedMemory *s) {
+    return s->map_addr;
+}
+
+void svcSleepThread(s64 nano);
+u32 crc32Calculate(const void *src, size_t size);
+void __attribute__((noreturn)) fatalThrow(Result err);
+
+typedef struct {
+    u8 address[0x6];
+} BtdrvAddress;
+
+typedef struct {
+    u8 class_of_device[0x3];
+} BtdrvClassOfDevice;
+
+typedef struct {
+    char code[0x10];
+} BtdrvBluetoothPinCode;
+
+typedef struct {
+    u8 type;
+    u8 size;
+    u8 data[0x100];
+} BtdrvAdapterProperty;
+
+typedef struct {
+    u16 size;
+    u8 data[0x280];
+} BtdrvHidReport;
+
+typedef u32 BtdrvBluetoothHhReportType;
+
+typedef struct {
+    BtdrvAddress addr;
+    char name[0x20];
+    BtdrvClassOfDevice class_of_device;
+    u8 link_key[0x10];
+    u8 link_key_set;
+    u16 version;
+    u32 trusted_services;
+    u16 vid;
+    u16 pid;
+    u8 sub_class;
+    u8 attribute_mask;
+    u16 descriptor_length;
+    u8 descriptor[0x80];
+    u8 key_type;
+    u8 device_type;
+    u16 brr_size;
+    u8 brr[0x9];
+    u8 audio_source_volume;
+    char name2[0xF9];
+    u8 audio_sink_volume;
+    u32 audio_flags;
+    u8 reserved[0x3C];
+} SetSysBluetoothDevicesSettings;
+
+typedef u32 BtdrvEventType;
+
+typedef union {
+    u8 data[0x400];
+} BtdrvEventInfo;
+
+typedef enum {
+    BtdrvHidEventTypeOld_Data = 5,
+    BtdrvHidEventType_Data    = 4,
+} BtdrvHidEventType;
+
+typedef union {
+    u8 data[0x480];
+} BtdrvHidEventInfo;
+
+typedef union {
+    u8 data[0x480];
+
+    union {
+        struct {
+            u8 unk_x0[0x11];
+            BtdrvAddress addr;
+            u8 pad[2];
+            BtdrvHidReport report;
+        } v7;
+
+        struct {
+            BtdrvAddress addr;
+            u8 unk_x6[0xB];
+            BtdrvHidReport report;
+        } v9;
+    } data_report;
+} BtdrvHidReportEventInfo;
+
+typedef u32 BtdrvBleEventType;
+
+typedef union {
+    u8 data[0x400];
+} BtdrvBleEventInfo;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner.hpp"
+#include "mcmitm_config.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_hid_report.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ams::mitm::host::runner {
+
+    namespace {
+
+        struct TestCase {
+            const char *name;
+            TestFunction func;
+            bool benchmark;
+        };
+
+        std::vector<TestCase> &GetTestCases(void) {
+            static std::vector<TestCase> s_cases;
+            return s_cases;
+        }
+
+        bool g_failed;
+        std::string g_sdmc_root;
+
+        std::string GetConfigPath(void) {
+            return g_sdmc_root + "/config/MissionControl/missioncontrol.ini";
+        }
+
+        void CreateSdCardRoot(void) {
+            char root[] = "/tmp/mc_host_XXXXXX";
+            if (!mkdtemp(root)) {
+                std::perror("mkdtemp");
+                std::exit(2);
+            }
+
+            g_sdmc_root = root;
+            mkdir((g_sdmc_root + "/config").c_str(), 0755);
+            mkdir((g_sdmc_root + "/config/MissionControl").c_str(), 0755);
+            setenv("MC_HOST_SDMC", root, 1);
+        }
+
+        void RemoveSdCardRoot(void) {
+            std::string command = "rm -rf " + g_sdmc_root;
+            std::system(command.c_str());
+        }
+
+    }
+
+    Registration::Registration(const char *name, TestFunction func, bool benchmark) {
+        GetTestCases().push_back({name, func, benchmark});
+    }
+
+    void Fail(const char *file, int line, const char *expr) {
+        std::printf("    %s:%d: check failed: %s\n", file, line, expr);
+        g_failed = true;
+    }
+
+    void WriteConfigFile(const char *ini) {
+        auto path = GetConfigPath();
+        auto f = std::fopen(path.c_str(), "w");
+        AMS_ABORT_UNLESS(f != nullptr);
+        std::fputs(ini, f);
+        std::fclose(f);
+    }
+
+    void WriteConfig(const char *ini) {
+        WriteConfigFile(ini);
+        R_ABORT_UNLESS(ReloadConfig());
+    }
+
+    size_t DrainInputReports(void) {
+        auto buffer = bluetooth::hid::report::GetFakeBuffer();
+
+        size_t count = 0;
+        while (buffer->Read()) {
+            buffer->Free();
+            ++count;
+        }
+
+        return count;
+    }
+
+}
+
+// Usage: mc_host_runner [--bench] [filter]
+// Runs the tests, or the benchmarks with --bench, whose names contain filter
+int main(int argc, char **argv) {
+    using namespace ams::mitm::host::runner;
+
+    bool benchmark = false;
+    const char *filter = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0)
+            benchmark = true;
+        else
+            filter = argv[i];
+    }
+
+    // Keep progress visible when a test hangs or aborts
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    CreateSdCardRoot();
+
+    size_t run = 0, failed = 0;
+    for (auto &test : GetTestCases()) {
+        if ((test.benchmark != benchmark) || (filter && !std::strstr(test.name, filter)))
+            continue;
+
+        // Every test starts from the built-in config
+        std::remove(GetConfigPath().c_str());
+        R_ABORT_UNLESS(ams::mitm::ReloadConfig());
+        DrainInputReports();
+
+        std::printf("[ RUN  ] %s\n", test.name);
+        g_failed = false;
+        test.func();
+        std::printf("[ %s ] %s\n", g_failed ? "FAIL" : " OK ", test.name);
+
+        ++run;
+        if (g_failed)
+            ++failed;
+    }
+
+    RemoveSdCardRoot();
+
+    std::printf("%zu run, %zu failed\n", run, failed);
+    return failed ? 1 : 0;
+}
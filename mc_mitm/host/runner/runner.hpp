@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <cstdio>
+#include <cinttypes>
+
+namespace ams::mitm::host::runner {
+
+    using TestFunction = void (*)(void);
+
+    struct Registration {
+        Registration(const char *name, TestFunction func, bool benchmark);
+    };
+
+    void Fail(const char *file, int line, const char *expr);
+
+    // Replace the config file under the fake sd card root
+    void WriteConfigFile(const char *ini);
+
+    // Replace the config file and reload it
+    void WriteConfig(const char *ini);
+
+    // Remove any input reports left in the fake buffer, returning how many there were
+    size_t DrainInputReports(void);
+
+    // Times iterations calls of func and prints the mean cost per call
+    template <typename F>
+    double Measure(const char *label, size_t iterations, F func) {
+        auto start = os::GetSystemTick();
+        for (size_t i = 0; i < iterations; ++i)
+            func(i);
+        auto elapsed = os::ConvertToTimeSpan(os::GetSystemTick() - start).GetNanoSeconds();
+
+        auto ns = double(elapsed) / iterations;
+        std::printf("    %-48s %10.1f ns/op\n", label, ns);
+        return ns;
+    }
+
+}
+
+#define MC_TEST_CONCAT_IMPL(a, b) a##b
+#define MC_TEST_CONCAT(a, b) MC_TEST_CONCAT_IMPL(a, b)
+
+#define MC_REGISTER(name, benchmark) \
+    static void MC_TEST_CONCAT(mc_test_, name)(void); \
+    static const ::ams::mitm::host::runner::Registration MC_TEST_CONCAT(mc_registration_, name)(#name, MC_TEST_CONCAT(mc_test_, name), benchmark); \
+    static void MC_TEST_CONCAT(mc_test_, name)(void)
+
+#define MC_TEST(name)       MC_REGISTER(name, false)
+#define MC_BENCHMARK(name)  MC_REGISTER(name, true)
+
+#define MC_CHECK(expr) \
+    do { if (!(expr)) { ::ams::mitm::host::runner::Fail(__FILE__, __LINE__, #expr); return; } } while (0)
+
+#define MC_CHECK_EQ(a, b) MC_CHECK((a) == (b))
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include <atomic>
+#include "mcmitm_host.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_hid_report.hpp"
+
+namespace ams::mitm::host {
+
+    namespace {
+
+        std::atomic<OutputReportHandler> g_output_report_handler;
+
+    }
+
+    void SetOutputReportHandler(OutputReportHandler handler) {
+        g_output_report_handler = handler;
+    }
+
+}
+
+namespace ams::bluetooth::hid::report {
+
+    namespace {
+
+        // Stands in for the shared memory buffer that btdrv would read translated input reports from
+        bluetooth::CircularBuffer *GetHostFakeBuffer(void) {
+            static bluetooth::CircularBuffer s_fake_buffer;
+            static bool s_initialized = [] {
+                s_fake_buffer.Initialize("HID Report");
+                s_fake_buffer.type = bluetooth::CircularBufferType_HidReport;
+                return true;
+            }();
+            (void)s_initialized;
+
+            return &s_fake_buffer;
+        }
+
+        os::SystemEvent g_system_event_fwd(os::EventClearMode_AutoClear, true);
+
+    }
+
+    bluetooth::CircularBuffer *GetFakeBuffer(void) {
+        return GetHostFakeBuffer();
+    }
+
+    os::SystemEvent *GetForwardEvent(void) {
+        return &g_system_event_fwd;
+    }
+
+    Result WriteHidReportBuffer(const bluetooth::Address *address, const bluetooth::HidReport *report, u64 *out_pending) {
+        return WriteHidReportBuffer(address, report->size, [report](bluetooth::HidReport *dst) {
+            std::memcpy(dst, report, report->size + sizeof(report->size));
+        }, out_pending);
+    }
+
+    Result SendHidReport(const bluetooth::Address *address, const bluetooth::HidReport *report) {
+        auto handler = mitm::host::g_output_report_handler.load();
+        if (handler)
+            handler(address, report);
+
+        return ams::ResultSuccess();
+    }
+
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ams {
+
+    namespace {
+
+        // Directory standing in for the root of the sd card, overridable with MC_HOST_SDMC
+        const char *GetSdCardRoot(void) {
+            auto root = std::getenv("MC_HOST_SDMC");
+            return root ? root : ".";
+        }
+
+        struct MountEntry {
+            std::string name;
+            std::string root;
+        };
+
+        std::mutex g_mount_lock;
+        std::vector<MountEntry> g_mounts;
+
+        bool ResolvePath(const char *path, std::string *out) {
+            auto separator = std::strstr(path, ":/");
+            if (!separator)
+                return false;
+
+            std::string name(path, separator - path);
+
+            std::scoped_lock lk(g_mount_lock);
+            for (auto &mount : g_mounts) {
+                if (mount.name == name) {
+                    *out = mount.root + (separator + 1);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        char *TrimWhitespace(char *str) {
+            while (std::isspace(static_cast<unsigned char>(*str)))
+                ++str;
+
+            auto end = str + std::strlen(str);
+            while ((end > str) && std::isspace(static_cast<unsigned char>(end[-1])))
+                --end;
+
+            *end = '\0';
+            return str;
+        }
+
+    }
+
+    namespace fs {
+
+        const WriteOption WriteOption::None  = { 0 };
+        const WriteOption WriteOption::Flush = { BIT(0) };
+
+        Result MountSdCard(const char *name) {
+            std::scoped_lock lk(g_mount_lock);
+            g_mounts.push_back({name, GetSdCardRoot()});
+
+            return ams::ResultSuccess();
+        }
+
+        void Unmount(const char *name) {
+            std::scoped_lock lk(g_mount_lock);
+            for (auto it = g_mounts.begin(); it != g_mounts.end(); ++it) {
+                if (it->name == name) {
+                    g_mounts.erase(it);
+                    return;
+                }
+            }
+        }
+
+        Result CreateDirectory(const char *path) {
+            std::string host_path;
+            if (!ResolvePath(path, &host_path))
+                return -1;
+
+            return ::mkdir(host_path.c_str(), 0755) == 0 ? ams::ResultSuccess() : -1;
+        }
+
+        Result CreateFile(const char *path, s64 size) {
+            std::string host_path;
+            if (!ResolvePath(path, &host_path))
+                return -1;
+
+            auto file = std::fopen(host_path.c_str(), "wb");
+            if (!file)
+                return -1;
+
+            ON_SCOPE_EXIT { std::fclose(file); };
+
+            return ::ftruncate(::fileno(file), size) == 0 ? ams::ResultSuccess() : -1;
+        }
+
+        Result OpenFile(FileHandle *out, const char *path, int mode) {
+            std::string host_path;
+            if (!ResolvePath(path, &host_path))
+                return -1;
+
+            auto file = std::fopen(host_path.c_str(), (mode & OpenMode_Write) ? "r+b" : "rb");
+            if (!file)
+                return -1;
+
+            out->handle = file;
+            return ams::ResultSuccess();
+        }
+
+        void CloseFile(FileHandle handle) {
+            std::fclose(reinterpret_cast<FILE *>(handle.handle));
+        }
+
+        Result ReadFile(size_t *out, FileHandle handle, s64 offset, void *buffer, size_t size) {
+            auto file = reinterpret_cast<FILE *>(handle.handle);
+            if (std::fseek(file, offset, SEEK_SET) != 0)
+                return -1;
+
+            *out = std::fread(buffer, 1, size, file);
+            return ams::ResultSuccess();
+        }
+
+        Result ReadFile(FileHandle handle, s64 offset, void *buffer, size_t size) {
+            size_t read_size;
+            R_TRY(ReadFile(&read_size, handle, offset, buffer, size));
+
+            return read_size == size ? ams::ResultSuccess() : -1;
+        }
+
+        Result WriteFile(FileHandle handle, s64 offset, const void *buffer, size_t size, const WriteOption &option) {
+            auto file = reinterpret_cast<FILE *>(handle.handle);
+            if ((std::fseek(file, offset, SEEK_SET) != 0) || (std::fwrite(buffer, 1, size, file) != size))
+                return -1;
+
+            if (option.value & WriteOption::Flush.value)
+                std::fflush(file);
+
+            return ams::ResultSuccess();
+        }
+
+        Result GetFileSize(s64 *out, FileHandle handle) {
+            struct stat st;
+            if (::fstat(::fileno(reinterpret_cast<FILE *>(handle.handle)), &st) != 0)
+                return -1;
+
+            *out = st.st_size;
+            return ams::ResultSuccess();
+        }
+
+        Result SetFileSize(FileHandle handle, s64 size) {
+            auto file = reinterpret_cast<FILE *>(handle.handle);
+            std::fflush(file);
+
+            return ::ftruncate(::fileno(file), size) == 0 ? ams::ResultSuccess() : -1;
+        }
+
+    }
+
+    namespace util::ini {
+
+        // Minimal ini reader matching the behaviour of the inih based parser used on console
+        s32 ParseFile(fs::FileHandle file, void *user_ctx, Handler h) {
+            auto fp = reinterpret_cast<FILE *>(file.handle);
+            std::rewind(fp);
+
+            char line[0x200];
+            char section[0x80] = "";
+            s32 line_number = 0;
+            s32 error = 0;
+
+            while (std::fgets(line, sizeof(line), fp)) {
+                ++line_number;
+
+                auto start = TrimWhitespace(line);
+                if ((*start == '\0') || (*start == ';') || (*start == '#'))
+                    continue;
+
+                if (*start == '[') {
+                    auto end = std::strchr(start, ']');
+                    if (end) {
+                        *end = '\0';
+                        std::snprintf(section, sizeof(section), "%s", start + 1);
+                    }
+                    else if (!error) {
+                        error = line_number;
+                    }
+
+                    continue;
+                }
+
+                auto separator = std::strpbrk(start, "=:");
+                if (!separator) {
+                    if (!error)
+                        error = line_number;
+
+                    continue;
+                }
+
+                *separator = '\0';
+                auto name = TrimWhitespace(start);
+                auto value = separator + 1;
+
+                // Strip inline comments
+                if (auto comment = std::strstr(value, " ;"); comment)
+                    *comment = '\0';
+
+                value = TrimWhitespace(value);
+
+                if (!h(user_ctx, section, name, value) && !error)
+                    error = line_number;
+            }
+
+            return error;
+        }
+
+    }
+
+}
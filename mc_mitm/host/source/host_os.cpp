@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stratosphere.hpp>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <map>
+#include <cstdio>
+
+namespace ams {
+
+    namespace hos {
+
+        Version GetVersion(void) {
+            // Report the newest firmware so the current btdrv structure layouts are used
+            return Version_12_0_0;
+        }
+
+    }
+
+    namespace os {
+
+        Tick GetSystemTick(void) {
+            return Tick(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        s64 GetSystemTickFrequency(void) {
+            return INT64_C(1000000000);
+        }
+
+        TimeSpan ConvertToTimeSpan(Tick tick) {
+            return TimeSpan::FromNanoSeconds(tick.GetInt64Value());
+        }
+
+        Tick ConvertToTick(TimeSpan ts) {
+            return Tick(ts.GetNanoSeconds());
+        }
+
+        void SleepThread(TimeSpan ts) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(ts.GetNanoSeconds()));
+        }
+
+        void InitializeEvent(EventType *event, bool signaled, EventClearMode clear_mode) {
+            event->signaled = signaled;
+            event->clear_mode = clear_mode;
+        }
+
+        void FinalizeEvent(EventType *event) {
+            (void)event;
+        }
+
+        void SignalEvent(EventType *event) {
+            {
+                std::scoped_lock lk(event->mutex);
+                event->signaled = true;
+            }
+
+            if (event->clear_mode == EventClearMode_AutoClear)
+                event->cv.notify_one();
+            else
+                event->cv.notify_all();
+        }
+
+        void WaitEvent(EventType *event) {
+            std::unique_lock lk(event->mutex);
+            event->cv.wait(lk, [event] { return event->signaled; });
+
+            if (event->clear_mode == EventClearMode_AutoClear)
+                event->signaled = false;
+        }
+
+        bool TryWaitEvent(EventType *event) {
+            std::scoped_lock lk(event->mutex);
+
+            bool signaled = event->signaled;
+            if (event->clear_mode == EventClearMode_AutoClear)
+                event->signaled = false;
+
+            return signaled;
+        }
+
+        bool TimedWaitEvent(EventType *event, TimeSpan timeout) {
+            std::unique_lock lk(event->mutex);
+            if (!event->cv.wait_for(lk, std::chrono::nanoseconds(timeout.GetNanoSeconds()), [event] { return event->signaled; }))
+                return false;
+
+            if (event->clear_mode == EventClearMode_AutoClear)
+                event->signaled = false;
+
+            return true;
+        }
+
+        void ClearEvent(EventType *event) {
+            std::scoped_lock lk(event->mutex);
+            event->signaled = false;
+        }
+
+    }
+
+}
+
+namespace {
+
+    struct SharedMemoryMapping {
+        void *address;
+        size_t ref_count;
+    };
+
+    // Mappings are keyed by handle, so a client loading the same handle sees the memory the sysmodule created
+    std::mutex g_shmem_lock;
+    std::map<Handle, SharedMemoryMapping> g_shmem_mappings;
+    Handle g_next_shmem_handle = INVALID_HANDLE;
+
+}
+
+extern "C" {
+
+    Result shmemCreate(SharedMemory *s, size_t size, Permission local_perm, Permission remote_perm) {
+        (void)remote_perm;
+
+        std::scoped_lock lk(g_shmem_lock);
+
+        s->handle = ++g_next_shmem_handle;
+        s->size = size;
+        s->perm = local_perm;
+        s->map_addr = nullptr;
+
+        return 0;
+    }
+
+    void shmemLoadRemote(SharedMemory *s, Handle handle, size_t size, Permission perm) {
+        s->handle = handle;
+        s->size = size;
+        s->perm = perm;
+        s->map_addr = nullptr;
+    }
+
+    Result shmemMap(SharedMemory *s) {
+        std::scoped_lock lk(g_shmem_lock);
+
+        auto it = g_shmem_mappings.find(s->handle);
+        if (it != g_shmem_mappings.end()) {
+            s->map_addr = it->second.address;
+            ++it->second.ref_count;
+            return 0;
+        }
+
+        s->map_addr = std::aligned_alloc(0x1000, (s->size + 0xfff) & ~0xfff);
+        if (!s->map_addr)
+            return -1;
+
+        std::memset(s->map_addr, 0, s->size);
+        g_shmem_mappings[s->handle] = {s->map_addr, 1};
+
+        return 0;
+    }
+
+    Result shmemUnmap(SharedMemory *s) {
+        std::scoped_lock lk(g_shmem_lock);
+
+        auto it = g_shmem_mappings.find(s->handle);
+        if ((it != g_shmem_mappings.end()) && (--it->second.ref_count == 0)) {
+            std::free(it->second.address);
+            g_shmem_mappings.erase(it);
+        }
+
+        s->map_addr = nullptr;
+
+        return 0;
+    }
+
+    Result shmemClose(SharedMemory *s) {
+        return s->map_addr ? shmemUnmap(s) : 0;
+    }
+
+    void svcSleepThread(s64 nano) {
+        ams::os::SleepThread(ams::TimeSpan::FromNanoSeconds(nano));
+    }
+
+    u32 crc32Calculate(const void *src, size_t size) {
+        auto data = reinterpret_cast<const u8 *>(src);
+
+        u32 crc = 0xffffffff;
+        for (size_t i = 0; i < size; ++i) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+
+        return ~crc;
+    }
+
+    void fatalThrow(Result err) {
+        std::fprintf(stderr, "fatal error 0x%x\n", err);
+        std::abort();
+    }
+
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "btm_mitm/btm_device_cache.hpp"
+
+namespace {
+
+    using namespace ams;
+
+    constexpr Result ResultFakeBtmUnavailable = 1;
+
+    struct FakeDeviceCondition {
+        u8 connected_count;
+        char names[8][0x20];
+    };
+
+    // Stands in for the real btm service behind the mitm, counting the queries forwarded to it
+    class FakeBtm {
+
+        public:
+            Result GetDeviceCondition(FakeDeviceCondition *out) {
+                ++m_fetch_count;
+                if (m_on_fetch) {
+                    m_on_fetch();
+                }
+
+                if (!m_available) {
+                    return ResultFakeBtmUnavailable;
+                }
+
+                *out = m_condition;
+                return ams::ResultSuccess();
+            }
+
+            void Connect(const char *name) {
+                std::strncpy(m_condition.names[m_condition.connected_count++], name, sizeof(m_condition.names[0]) - 1);
+            }
+
+            void RemoveDeviceInfo(void) {
+                --m_condition.connected_count;
+                mitm::btm::InvalidateDeviceCache();
+            }
+
+            FakeDeviceCondition m_condition = {};
+            size_t m_fetch_count = 0;
+            bool m_available = true;
+            void (*m_on_fetch)(void) = nullptr;
+    };
+
+    Result GetCachedCondition(mitm::btm::DeviceCache<FakeDeviceCondition> *cache, FakeBtm *btm, FakeDeviceCondition *out) {
+        return cache->Get(out, [btm](FakeDeviceCondition *condition) {
+            return btm->GetDeviceCondition(condition);
+        });
+    }
+
+}
+
+MC_TEST(btm_cache_serves_repeat_queries) {
+    mitm::btm::DeviceCache<FakeDeviceCondition> cache;
+    FakeBtm btm;
+    btm.Connect("Xbox Wireless Controller");
+
+    FakeDeviceCondition condition;
+    for (size_t i = 0; i < 10; ++i) {
+        MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    }
+
+    MC_CHECK_EQ(btm.m_fetch_count, 1u);
+    MC_CHECK_EQ(condition.connected_count, 1);
+}
+
+MC_TEST(btm_cache_refetches_after_device_removed) {
+    mitm::btm::DeviceCache<FakeDeviceCondition> cache;
+    FakeBtm btm;
+    btm.Connect("Xbox Wireless Controller");
+    btm.Connect("Wireless Controller");
+
+    FakeDeviceCondition condition;
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    MC_CHECK_EQ(condition.connected_count, 2);
+
+    btm.RemoveDeviceInfo();
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    MC_CHECK_EQ(btm.m_fetch_count, 2u);
+    MC_CHECK_EQ(condition.connected_count, 1);
+}
+
+MC_TEST(btm_cache_refetches_after_invalidation_during_fetch) {
+    mitm::btm::DeviceCache<FakeDeviceCondition> cache;
+    FakeBtm btm;
+
+    // A condition change landing while btm is being queried may not be reflected in the response
+    btm.m_on_fetch = [] { mitm::btm::InvalidateDeviceCache(); };
+
+    FakeDeviceCondition condition;
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+
+    btm.m_on_fetch = nullptr;
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    MC_CHECK_EQ(btm.m_fetch_count, 2u);
+}
+
+MC_TEST(btm_cache_does_not_keep_failed_queries) {
+    mitm::btm::DeviceCache<FakeDeviceCondition> cache;
+    FakeBtm btm;
+    btm.Connect("Xbox Wireless Controller");
+
+    FakeDeviceCondition condition;
+    btm.m_available = false;
+    MC_CHECK_EQ(GetCachedCondition(&cache, &btm, &condition), ResultFakeBtmUnavailable);
+
+    btm.m_available = true;
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    MC_CHECK(R_SUCCEEDED(GetCachedCondition(&cache, &btm, &condition)));
+    MC_CHECK_EQ(btm.m_fetch_count, 2u);
+    MC_CHECK_EQ(condition.connected_count, 1);
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_host.hpp"
+#include "controllers/button_combos.hpp"
+#include "controllers/switch_controller.hpp"
+
+namespace {
+
+    using namespace ams;
+    using namespace ams::controller;
+
+    constexpr uint32_t home_chord = SwitchButton_Minus | SwitchButton_DpadDown;
+    constexpr uint32_t capture_chord = SwitchButton_Minus | SwitchButton_DpadUp;
+
+    constexpr mitm::ButtonComboConfig default_combos[] = {
+        {home_chord, SwitchButton_Home, 0},
+        {capture_chord, SwitchButton_Capture, 0},
+    };
+
+    // MINUS chords that the benchmark input never completes, half of them with a hold time. Together they use as
+    // many chord buttons as can be compiled into a table
+    void ConfigureFillerCombos(ButtonCombos *combos, size_t count) {
+        constexpr uint32_t chord_buttons[] = {
+            SwitchButton_DpadDown, SwitchButton_DpadUp, SwitchButton_DpadLeft, SwitchButton_DpadRight,
+            SwitchButton_L, SwitchButton_R, SwitchButton_ZL, SwitchButton_L | SwitchButton_R,
+        };
+
+        mitm::ButtonComboConfig configs[mitm::MaxButtonCombos];
+        for (size_t i = 0; i < count; ++i)
+            configs[i] = {SwitchButton_Minus | chord_buttons[i], SwitchButton_Home, i % 2 ? 500u : 0u};
+
+        combos->Configure(configs, count);
+    }
+
+    // Feeds an official controller a 0x30 report holding buttons and returns the buttons it wrote to the fake buffer
+    uint32_t HandleOfficialReport(const char *ini, uint32_t buttons) {
+        constexpr bluetooth::Address address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+
+        ams::mitm::host::SetOutputReportHandler(nullptr);
+        ams::mitm::host::runner::WriteConfig(ini);
+        ams::mitm::host::runner::DrainInputReports();
+
+        // Pro Controller
+        auto config = mitm::AcquireConfig();
+        SwitchController controller(&address);
+        controller.SetProfile(config, mitm::FindControllerProfile(config, &address, 0x057e, 0x2009));
+        mitm::ReleaseConfig(config);
+
+        bluetooth::HidReport report = {};
+        report.size = 0x31;
+        auto switch_report = reinterpret_cast<SwitchReportData *>(report.data);
+        switch_report->id = 0x30;
+        MaskToButtonData(buttons, &switch_report->input0x30.buttons);
+        controller.HandleIncomingReport(&report);
+
+        auto packet = bluetooth::hid::report::GetFakeBuffer()->Read();
+        if (packet == nullptr)
+            return 0;
+
+        auto written = reinterpret_cast<const SwitchReportData *>(packet->data.data_report.v9.report.data);
+        auto mask = ButtonDataToMask(&written->input0x30.buttons);
+        ams::mitm::host::runner::DrainInputReports();
+        return mask;
+    }
+
+}
+
+MC_TEST(button_combos_replace_chord) {
+    ButtonCombos combos;
+    combos.Configure(default_combos, std::size(default_combos));
+
+    MC_CHECK_EQ(combos.Apply(SwitchButton_A), uint32_t(SwitchButton_A));
+    MC_CHECK_EQ(combos.Apply(SwitchButton_Minus), uint32_t(SwitchButton_Minus));
+    MC_CHECK_EQ(combos.Apply(home_chord | SwitchButton_A), uint32_t(SwitchButton_Home | SwitchButton_A));
+    MC_CHECK_EQ(combos.Apply(capture_chord), uint32_t(SwitchButton_Capture));
+}
+
+MC_TEST(button_combos_suppress_chord_until_released) {
+    ButtonCombos combos;
+    combos.Configure(default_combos, std::size(default_combos));
+
+    MC_CHECK_EQ(combos.Apply(home_chord), uint32_t(SwitchButton_Home));
+
+    // Letting go of one chord button mustn't leak a press of the other
+    MC_CHECK_EQ(combos.Apply(SwitchButton_Minus), 0u);
+    MC_CHECK_EQ(combos.Apply(0), 0u);
+    MC_CHECK_EQ(combos.Apply(SwitchButton_Minus), uint32_t(SwitchButton_Minus));
+}
+
+MC_TEST(button_combos_wait_for_hold_time) {
+    const mitm::ButtonComboConfig config = {SwitchButton_L | SwitchButton_R, SwitchButton_Home, 50};
+
+    ButtonCombos combos;
+    combos.Configure(&config, 1);
+
+    // The chord passes through until it has been held long enough
+    MC_CHECK_EQ(combos.Apply(SwitchButton_L | SwitchButton_R), uint32_t(SwitchButton_L | SwitchButton_R));
+    os::SleepThread(TimeSpan::FromMilliSeconds(60));
+    MC_CHECK_EQ(combos.Apply(SwitchButton_L | SwitchButton_R), uint32_t(SwitchButton_Home));
+
+    // Releasing the chord restarts the timer
+    MC_CHECK_EQ(combos.Apply(0), 0u);
+    MC_CHECK_EQ(combos.Apply(SwitchButton_L | SwitchButton_R), uint32_t(SwitchButton_L | SwitchButton_R));
+}
+
+MC_TEST(button_combos_chain_outputs) {
+    // iCade style combos, whose outputs complete the built-in MINUS chords
+    const mitm::ButtonComboConfig configs[] = {
+        {SwitchButton_ZL | SwitchButton_ZR | SwitchButton_L, SwitchButton_Minus, 0},
+        {SwitchButton_ZL | SwitchButton_ZR | SwitchButton_R, SwitchButton_Plus, 0},
+        {home_chord, SwitchButton_Home, 0},
+        {capture_chord, SwitchButton_Capture, 0},
+    };
+
+    ButtonCombos combos;
+    combos.Configure(configs, std::size(configs));
+    MC_CHECK(combos.IsCompiled());
+
+    MC_CHECK_EQ(combos.Apply(SwitchButton_ZL | SwitchButton_ZR | SwitchButton_L), uint32_t(SwitchButton_Minus));
+    MC_CHECK_EQ(combos.Apply(0), 0u);
+    MC_CHECK_EQ(combos.Apply(SwitchButton_ZL | SwitchButton_ZR | SwitchButton_L | SwitchButton_DpadDown), uint32_t(SwitchButton_Home));
+    MC_CHECK_EQ(combos.Apply(SwitchButton_DpadDown), 0u);
+}
+
+MC_TEST(button_combos_compiled_match_in_order) {
+    // Too many chord buttons to compile, so the same combos are evaluated in order
+    constexpr uint32_t extra_chord = SwitchButton_A | SwitchButton_B | SwitchButton_X | SwitchButton_Y | SwitchButton_Plus;
+    const mitm::ButtonComboConfig configs[] = {
+        {SwitchButton_ZL | SwitchButton_ZR | SwitchButton_L, SwitchButton_Minus, 0},
+        {home_chord, SwitchButton_Home, 0},
+        {capture_chord | SwitchButton_L, SwitchButton_Capture | SwitchButton_R, 0},
+        {SwitchButton_ZL | SwitchButton_R, SwitchButton_DpadUp, 0},
+        {extra_chord, SwitchButton_RStick, 0},
+    };
+
+    ButtonCombos compiled;
+    compiled.Configure(configs, std::size(configs) - 1);
+    MC_CHECK(compiled.IsCompiled());
+
+    ButtonCombos in_order;
+    in_order.Configure(configs, std::size(configs));
+    MC_CHECK(!in_order.IsCompiled());
+
+    // Walk through every combination of the compiled chord buttons, so suppression is carried from one state to the next
+    constexpr uint32_t chord_buttons[] = {
+        SwitchButton_ZL, SwitchButton_ZR, SwitchButton_L, SwitchButton_R, SwitchButton_Minus, SwitchButton_DpadDown, SwitchButton_DpadUp,
+    };
+
+    for (uint32_t step = 0; step < 4 * BIT(std::size(chord_buttons)); ++step) {
+        // Gray code, so at most one button changes at a time
+        uint32_t gray = step ^ (step >> 1);
+        uint32_t buttons = SwitchButton_A;
+        for (size_t i = 0; i < std::size(chord_buttons); ++i) {
+            if (gray & BIT(i))
+                buttons |= chord_buttons[i];
+        }
+
+        MC_CHECK_EQ(compiled.Apply(buttons), in_order.Apply(buttons));
+    }
+}
+
+MC_TEST(button_combos_official_controllers) {
+    // Built-in combos apply to official controllers too, which include pads without HOME and CAPTURE buttons
+    MC_CHECK_EQ(HandleOfficialReport("", home_chord), uint32_t(SwitchButton_Home));
+
+    // Disabled, or nothing left to apply, reports pass through untouched
+    MC_CHECK_EQ(HandleOfficialReport("[misc]\nenable_official_controller_combos=false\n", home_chord), home_chord);
+    MC_CHECK_EQ(HandleOfficialReport("[profile:default]\ncombo=none\n", home_chord), home_chord);
+
+    ams::mitm::host::runner::WriteConfig("");
+}
+
+MC_BENCHMARK(button_combos) {
+    char label[0x40];
+
+    double held_cost[mitm::MaxButtonCombos + 1] = {};
+    for (size_t count : {0, 1, 2, 4, 8}) {
+        ButtonCombos combos;
+        ConfigureFillerCombos(&combos, count);
+        MC_CHECK((count == 0) || combos.IsCompiled());
+
+        // Ordinary play, no chord button held
+        std::snprintf(label, sizeof(label), "%zu combos, no chord button held", count);
+        ams::mitm::host::runner::Measure(label, 1000000, [&](size_t i) {
+            volatile auto buttons = combos.Apply(uint32_t(i) & (SwitchButton_A | SwitchButton_B | SwitchButton_X | SwitchButton_Y));
+            (void)buttons;
+        });
+
+        // A chord button held, which takes a table lookup however many chords it is part of
+        std::snprintf(label, sizeof(label), "%zu combos, chord button held", count);
+        held_cost[count] = ams::mitm::host::runner::Measure(label, 1000000, [&](size_t i) {
+            volatile auto buttons = combos.Apply(SwitchButton_Minus | (uint32_t(i) & (SwitchButton_A | SwitchButton_B)));
+            (void)buttons;
+        });
+    }
+
+    // Defining more combos mustn't make reports more expensive, allowing for timing noise
+    MC_CHECK(held_cost[mitm::MaxButtonCombos] < 1.5 * held_cost[1] + 1.0);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_circular_buffer.hpp"
+
+namespace {
+
+    using namespace ams;
+
+    bluetooth::CircularBuffer *GetTestBuffer(void) {
+        static bluetooth::CircularBuffer s_buffer;
+
+        // Start every test from an empty buffer at offset zero
+        if (s_buffer.IsInitialized())
+            s_buffer.Finalize();
+
+        s_buffer.Initialize("Test");
+        s_buffer.type = bluetooth::CircularBufferType_HidReport;
+
+        return &s_buffer;
+    }
+
+    bool WritePacket(bluetooth::CircularBuffer *buffer, u8 value, size_t size) {
+        return buffer->Write(BtdrvHidEventType_Data, size, [=](bluetooth::HidReportEventInfo *info) {
+            std::memset(info, value, size);
+        }) == 0;
+    }
+
+}
+
+MC_TEST(circular_buffer_reads_in_write_order) {
+    auto buffer = GetTestBuffer();
+
+    for (u8 i = 0; i < 3; ++i)
+        MC_CHECK(WritePacket(buffer, i, 0x40));
+
+    for (u8 i = 0; i < 3; ++i) {
+        auto packet = buffer->Read();
+        MC_CHECK(packet != nullptr);
+        MC_CHECK_EQ(packet->header.size, 0x40u);
+        MC_CHECK_EQ(reinterpret_cast<u8 *>(&packet->data)[0], i);
+        buffer->Free();
+    }
+
+    MC_CHECK(buffer->Read() == nullptr);
+}
+
+MC_TEST(circular_buffer_rejects_writes_when_full) {
+    auto buffer = GetTestBuffer();
+
+    // Leave the reader just short of where the first packet after wrapping around will end
+    MC_CHECK(WritePacket(buffer, 0, 0xce));
+    buffer->Read();
+    buffer->Free();
+
+    size_t written = 0;
+    while (WritePacket(buffer, u8(written), 0x100))
+        ++written;
+
+    MC_CHECK(written > 0);
+    MC_CHECK(!WritePacket(buffer, 0xff, 0x100));
+
+    // Nothing already queued may have been overwritten
+    size_t read = 0;
+    while (auto packet = buffer->Read()) {
+        MC_CHECK_EQ(reinterpret_cast<u8 *>(&packet->data)[0], u8(read));
+        buffer->Free();
+        ++read;
+    }
+
+    MC_CHECK_EQ(read, written);
+    MC_CHECK(WritePacket(buffer, 0, 0x100));
+}
+
+MC_TEST(circular_buffer_wraps_around) {
+    auto buffer = GetTestBuffer();
+
+    // Enough packets to wrap the buffer several times, consuming each one as it is written
+    for (size_t i = 0; i < 4 * bluetooth::BLUETOOTH_BUFFER_SIZE / 0x80; ++i) {
+        MC_CHECK(WritePacket(buffer, u8(i), 0x80));
+
+        auto packet = buffer->Read();
+        MC_CHECK(packet != nullptr);
+        MC_CHECK_EQ(reinterpret_cast<u8 *>(&packet->data)[0x7f], u8(i));
+        buffer->Free();
+    }
+}
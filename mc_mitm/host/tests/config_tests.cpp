@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_config.hpp"
+#include "controllers/switch_controller.hpp"
+#include "controllers/button_remap.hpp"
+#include "controllers/keyboard_translator.hpp"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+    using namespace ams;
+
+    constexpr bluetooth::Address test_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+
+    struct ScopedConfig {
+        const mitm::MissionControlConfig *config;
+
+        ScopedConfig(void) : config(mitm::AcquireConfig()) { };
+        ~ScopedConfig(void) { mitm::ReleaseConfig(config); };
+
+        const mitm::MissionControlConfig *operator->(void) const { return config; }
+    };
+
+}
+
+MC_TEST(config_defaults) {
+    ScopedConfig config;
+
+    MC_CHECK(config->general.enable_rumble);
+    MC_CHECK(config->general.enable_motion);
+    MC_CHECK(config->misc.enable_official_controller_combos);
+
+    auto profile = mitm::FindControllerProfile(config.config, &test_address, 0x054c, 0x05c4);
+    MC_CHECK(profile != nullptr);
+    MC_CHECK_EQ(profile->key, mitm::ControllerProfileKey_Default);
+    MC_CHECK_EQ(profile->num_combos, 2u);
+}
+
+MC_TEST(config_parses_sections) {
+    ams::mitm::host::runner::WriteConfig(
+        "[general]\n"
+        "enable_rumble=false\n"
+        "[bluetooth]\n"
+        "host_name=Test Switch\n"
+        "host_address=aa:bb:cc:dd:ee:ff\n"
+        "[misc]\n"
+        "cpu_budget_percent=250\n"
+    );
+
+    ScopedConfig config;
+
+    MC_CHECK(!config->general.enable_rumble);
+    MC_CHECK(config->general.enable_motion);
+    MC_CHECK(std::strcmp(config->bluetooth.host_name, "Test Switch") == 0);
+    MC_CHECK_EQ(config->bluetooth.host_address.address[0], 0xaa);
+    MC_CHECK_EQ(config->bluetooth.host_address.address[5], 0xff);
+    MC_CHECK_EQ(config->misc.cpu_budget_percent, 100u);
+}
+
+MC_TEST(config_profile_precedence) {
+    ams::mitm::host::runner::WriteConfig(
+        "[profile:054c:05c4]\n"
+        "pacing_interval_ms=8\n"
+        "[profile:01:02:03:04:05:06]\n"
+        "pacing_interval_ms=16\n"
+    );
+
+    ScopedConfig config;
+
+    constexpr bluetooth::Address other_address = {{0x06, 0x05, 0x04, 0x03, 0x02, 0x01}};
+
+    auto profile = mitm::FindControllerProfile(config.config, &test_address, 0x054c, 0x05c4);
+    MC_CHECK(profile && profile->key == mitm::ControllerProfileKey_Address);
+    MC_CHECK_EQ(profile->pacing_interval_ms, 16u);
+
+    profile = mitm::FindControllerProfile(config.config, &other_address, 0x054c, 0x05c4);
+    MC_CHECK(profile && profile->key == mitm::ControllerProfileKey_HardwareId);
+    MC_CHECK_EQ(profile->pacing_interval_ms, 8u);
+
+    profile = mitm::FindControllerProfile(config.config, &other_address, 0x045e, 0x02e0);
+    MC_CHECK(profile && profile->key == mitm::ControllerProfileKey_Default);
+}
+
+MC_TEST(config_reload_keeps_acquired_snapshot) {
+    ScopedConfig before;
+    MC_CHECK(mitm::IsCurrentConfig(before.config));
+
+    ams::mitm::host::runner::WriteConfig("[general]\nenable_motion=false\n");
+
+    ScopedConfig after;
+    MC_CHECK(!mitm::IsCurrentConfig(before.config));
+    MC_CHECK(mitm::IsCurrentConfig(after.config));
+    MC_CHECK(before->general.enable_motion);
+    MC_CHECK(!after->general.enable_motion);
+}
+
+MC_TEST(config_reload_busy_while_every_snapshot_held) {
+    auto first = mitm::AcquireConfig();
+    ams::mitm::host::runner::WriteConfig("");
+    auto second = mitm::AcquireConfig();
+    ams::mitm::host::runner::WriteConfig("");
+
+    // Two older snapshots are still held alongside the current one, so there is nowhere to build another
+    auto rc = mitm::ReloadConfig();
+    mitm::ReleaseConfig(first);
+    MC_CHECK_EQ(rc, os::ResultBusy());
+
+    rc = mitm::ReloadConfig();
+    mitm::ReleaseConfig(second);
+    MC_CHECK(R_SUCCEEDED(rc));
+}
+
+MC_TEST(config_cached_config_follows_reloads) {
+    ams::mitm::host::runner::WriteConfig("[general]\nenable_rumble=false\n");
+
+    mitm::CachedConfig cached;
+    auto config = cached.Get();
+    MC_CHECK(!config->general.enable_rumble);
+    MC_CHECK(cached.Get() == config);
+
+    ams::mitm::host::runner::WriteConfig("");
+    MC_CHECK(cached.Get() != config);
+    MC_CHECK(cached.Get()->general.enable_rumble);
+}
+
+MC_TEST(config_acquire_races_reload) {
+    std::atomic<bool> done = false;
+    std::atomic<size_t> torn = 0;
+    size_t failed = 0;
+
+    // Readers never take a lock, and must never see a snapshot being rebuilt underneath them
+    auto reader = [&] {
+        while (!done.load()) {
+            auto config = mitm::AcquireConfig();
+            if (config->general.enable_rumble != config->general.enable_motion)
+                ++torn;
+            mitm::ReleaseConfig(config);
+        }
+    };
+
+    std::thread readers[] = { std::thread(reader), std::thread(reader) };
+
+    // Reloads can find every slot briefly held by readers, and are retried as a client would
+    size_t reloads = 0;
+    for (size_t i = 0; i < 200; ++i) {
+        auto ini = (i % 2) ? "[general]\nenable_rumble=false\nenable_motion=false\n" : "";
+        ams::mitm::host::runner::WriteConfigFile(ini);
+        for (size_t attempt = 0; attempt < 100; ++attempt) {
+            auto rc = mitm::ReloadConfig();
+            if (R_SUCCEEDED(rc)) {
+                ++reloads;
+                break;
+            }
+
+            if (rc != os::ResultBusy())
+                ++failed;
+        }
+    }
+
+    done = true;
+    for (auto &thread : readers)
+        thread.join();
+
+    MC_CHECK_EQ(torn.load(), 0u);
+    MC_CHECK_EQ(failed, 0u);
+    MC_CHECK(reloads > 0);
+    ams::mitm::host::runner::WriteConfig("");
+}
+
+MC_TEST(config_remap_and_keymap) {
+    ams::mitm::host::runner::WriteConfig(
+        "[profile:default]\n"
+        "remap=A,B\n"
+        "remap=B,A\n"
+        "remap=DPAD_RIGHT,none\n"
+        "keymap=0x04,hold,X\n"
+        "keymap=0x05,hold,Y\n"
+        "keymap=0x04,press,ZR\n"
+    );
+
+    ScopedConfig config;
+
+    auto profile = mitm::FindControllerProfile(config.config, &test_address, 0x054c, 0x05c4);
+    MC_CHECK(profile && profile->remap_buttons);
+
+    controller::ButtonRemap remap;
+    remap.Configure(profile);
+    MC_CHECK(remap.IsEnabled());
+    MC_CHECK(remap.IsCompiled());
+    MC_CHECK_EQ(remap.Apply(controller::SwitchButton_A), uint32_t(controller::SwitchButton_B));
+    MC_CHECK_EQ(remap.Apply(controller::SwitchButton_B | controller::SwitchButton_Capture), uint32_t(controller::SwitchButton_A | controller::SwitchButton_Capture));
+    MC_CHECK_EQ(remap.Apply(controller::SwitchButton_DpadRight | controller::SwitchButton_ZR), uint32_t(controller::SwitchButton_ZR));
+
+    // Mapping a key again replaces its earlier entry rather than adding another
+    MC_CHECK_EQ(profile->num_keymaps, 2u);
+
+    constexpr controller::KeyboardKeyBinding bindings[] = {
+        {0x05, {controller::SwitchButton_A, mitm::KeyboardKeyAction_Hold}},
+        {0x06, {controller::SwitchButton_B, mitm::KeyboardKeyAction_Hold}},
+    };
+
+    controller::KeyboardTranslator translator(bindings);
+    translator.Configure(profile);
+
+    controller::BootKeyboardReport report = {0, 0, {0x04, 0x05, 0x06}};
+    MC_CHECK_EQ(translator.Apply(&report), uint32_t(controller::SwitchButton_ZR | controller::SwitchButton_Y | controller::SwitchButton_B));
+}
+
+MC_TEST(config_profiles_keep_builtin_combos_unless_set) {
+    ams::mitm::host::runner::WriteConfig(
+        "[profile:default]\n"
+        "remap=A,nonesense\n"
+        "[profile:054c:05c4]\n"
+        "pacing_interval_ms=8\n"
+        "[profile:01:02:03:04:05:06]\n"
+        "combo=none\n"
+    );
+
+    ScopedConfig config;
+
+    constexpr bluetooth::Address other_address = {{0x06, 0x05, 0x04, 0x03, 0x02, 0x01}};
+
+    // Only a prefix of none, so the remap is rejected
+    auto profile = mitm::FindControllerProfile(config.config, &other_address, 0x045e, 0x02e0);
+    MC_CHECK(profile && profile->key == mitm::ControllerProfileKey_Default);
+    MC_CHECK(!profile->remap_buttons);
+    MC_CHECK_EQ(profile->num_combos, 2u);
+
+    profile = mitm::FindControllerProfile(config.config, &other_address, 0x054c, 0x05c4);
+    MC_CHECK(profile && profile->key == mitm::ControllerProfileKey_HardwareId);
+    MC_CHECK_EQ(profile->num_combos, 2u);
+    MC_CHECK_EQ(profile->combos[0].output, uint32_t(controller::SwitchButton_Home));
+
+    profile = mitm::FindControllerProfile(config.config, &test_address, 0x054c, 0x05c4);
+    MC_CHECK(profile && profile->key == mitm::ControllerProfileKey_Address);
+    MC_CHECK_EQ(profile->num_combos, 0u);
+}
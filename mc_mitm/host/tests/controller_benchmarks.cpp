@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_host.hpp"
+#include "controllers/dualshock4_controller.hpp"
+#include "controllers/dualsense_controller.hpp"
+#include "controllers/xbox_one_controller.hpp"
+
+namespace {
+
+    using namespace ams;
+
+    constexpr bluetooth::Address test_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+    constexpr size_t iterations = 200000;
+
+    // Translates the same input report repeatedly, consuming each translated report as btdrv would
+    template <typename T>
+    void MeasureTranslation(const char *label, uint8_t id, uint16_t size) {
+        T controller(&test_address);
+        R_ABORT_UNLESS(controller.Initialize());
+
+        bluetooth::HidReport report = {};
+        report.size = size;
+        report.data[0] = id;
+
+        ams::mitm::host::runner::Measure(label, iterations, [&](size_t i) {
+            // Vary the sticks so the translation can't be skipped
+            report.data[2] = uint8_t(i);
+            controller.HandleIncomingReport(&report);
+            ams::mitm::host::runner::DrainInputReports();
+        });
+    }
+
+}
+
+MC_BENCHMARK(controller_translation) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    MeasureTranslation<controller::Dualshock4Controller>("Dualshock4 report 0x11", 0x11, 79);
+    MeasureTranslation<controller::DualsenseController>("Dualsense report 0x31", 0x31, 78);
+    MeasureTranslation<controller::XboxOneController>("Xbox One report 0x01", 0x01, sizeof(controller::XboxOneInputReport0x01) + 1);
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_corpus.hpp"
+#include "controllers/8bitdo_controller.hpp"
+#include "controllers/atgames_controller.hpp"
+#include "controllers/dualsense_controller.hpp"
+#include "controllers/dualshock4_controller.hpp"
+#include "controllers/gamesir_controller.hpp"
+#include "controllers/gamestick_controller.hpp"
+#include "controllers/gembox_controller.hpp"
+#include "controllers/icade_controller.hpp"
+#include "controllers/ipega_controller.hpp"
+#include "controllers/keyboard_controller.hpp"
+#include "controllers/lanshen_controller.hpp"
+#include "controllers/mad_catz_controller.hpp"
+#include "controllers/mocute_controller.hpp"
+#include "controllers/nvidia_shield_controller.hpp"
+#include "controllers/ouya_controller.hpp"
+#include "controllers/powera_controller.hpp"
+#include "controllers/razer_controller.hpp"
+#include "controllers/steelseries_controller.hpp"
+#include "controllers/wii_controller.hpp"
+#include "controllers/xbox_one_controller.hpp"
+#include "controllers/xiaomi_controller.hpp"
+#include "controllers/load_governor.hpp"
+#include <algorithm>
+
+namespace ams::mitm::host::corpus {
+
+    namespace {
+
+        // Behaves exactly like T, adding the baseline path. The decoder is reached through an indirect call, as the virtual
+        // UpdateControllerState used to be. The report's button field is written twice, once with the decoded state and again
+        // after the button profile has been applied
+        template <typename T>
+        class BaselineController : public T, public BaselineDispatch {
+
+            public:
+                using T::T;
+
+                Result HandleIncomingReportBaseline(const bluetooth::HidReport *report) {
+                    (this->*s_decoder)(report);
+
+                    auto now = os::GetSystemTick();
+                    if ((this->GetPacingInterval().GetInt64Value() != 0) || (controller::GetLoadLevel() != controller::LoadLevel_Full))
+                        return this->ForwardInputReport();
+
+                    uint32_t buttons = controller::ButtonDataToMask(&this->m_buttons) | this->m_pacing_buttons;
+                    this->m_pacing_buttons = 0;
+                    this->m_report_pending = false;
+                    this->m_next_report_tick = now + std::max(this->GetPacingInterval(), controller::GetMinimumReportInterval());
+
+                    return this->WriteHidReportBuffer(sizeof(controller::SwitchInputReport0x30) + 1, [&](bluetooth::HidReport *dst) {
+                        dst->size = sizeof(controller::SwitchInputReport0x30) + 1;
+                        auto switch_report = reinterpret_cast<controller::SwitchReportData *>(dst->data);
+                        switch_report->id = 0x30;
+                        switch_report->input0x30.conn_info      = 0;
+                        switch_report->input0x30.battery        = this->m_battery | this->m_charging;
+                        controller::MaskToButtonData(buttons, &switch_report->input0x30.buttons);
+                        switch_report->input0x30.left_stick     = this->m_left_stick;
+                        switch_report->input0x30.right_stick    = this->m_right_stick;
+                        switch_report->input0x30.vibrator       = 0;
+                        std::memcpy(&switch_report->input0x30.motion, &this->m_motion_data, sizeof(this->m_motion_data));
+
+                        this->ApplyButtonProfile(&switch_report->input0x30.buttons);
+
+                        switch_report->input0x30.timer = os::ConvertToTimeSpan(now).GetMilliSeconds() & 0xff;
+
+                        this->PublishInputReport(switch_report);
+                    });
+                }
+
+            private:
+                // Read through a volatile so the compiler can't resolve the call
+                static void (T::* volatile s_decoder)(const bluetooth::HidReport *report);
+
+        };
+
+        template <typename T>
+        void (T::* volatile BaselineController<T>::s_decoder)(const bluetooth::HidReport *report) = &T::UpdateControllerState;
+
+        template <typename T>
+        controller::SwitchController *Create(const bluetooth::Address *address) {
+            return new BaselineController<T>(address);
+        }
+
+        constexpr ControllerCase controller_cases[] = {
+            { "8BitDo",         Create<controller::EightBitDoController>,   0x03, 11 },
+            { "AtGames",        Create<controller::AtGamesController>,      0x01, 20 },
+            { "Dualsense",      Create<controller::DualsenseController>,    0x31, 78 },
+            { "Dualshock4",     Create<controller::Dualshock4Controller>,   0x11, 79 },
+            { "Gamesir",        Create<controller::GamesirController>,      0x12, 20 },
+            { "Gamestick",      Create<controller::GamestickController>,    0x03, 20 },
+            { "Gembox",         Create<controller::GemboxController>,       0x07, 20 },
+            { "iCade",          Create<controller::ICadeController>,        0x01,  9 },
+            { "Ipega",          Create<controller::IpegaController>,        0x07, 20 },
+            { "Keyboard",       Create<controller::KeyboardController>,     0x01,  9 },
+            { "LanShen",        Create<controller::LanShenController>,      0x01, 20 },
+            { "Mad Catz",       Create<controller::MadCatzController>,      0x01, 20 },
+            { "Mocute",         Create<controller::MocuteController>,       0x01, 20 },
+            { "Nvidia Shield",  Create<controller::NvidiaShieldController>, 0x01, 20 },
+            { "Ouya",           Create<controller::OuyaController>,         0x07, 20 },
+            { "PowerA",         Create<controller::PowerAController>,       0x03, 20 },
+            { "Razer",          Create<controller::RazerController>,        0x01, 20 },
+            { "Steelseries",    Create<controller::SteelseriesController>,  0x01, sizeof(controller::SteelseriesInputReport0x01) + 1 },
+            { "Wii",            Create<controller::WiiController>,          0x30,  3 },
+            { "Xbox One",       Create<controller::XboxOneController>,      0x01, sizeof(controller::XboxOneInputReport0x01) + 1 },
+            { "Xiaomi",         Create<controller::XiaomiController>,       0x04, 20 },
+        };
+
+    }
+
+    std::span<const ControllerCase> GetControllerCases(void) {
+        return controller_cases;
+    }
+
+    std::unique_ptr<controller::SwitchController> CreateController(const ControllerCase &c, const bluetooth::Address *address) {
+        std::unique_ptr<controller::SwitchController> controller(c.create(address));
+        R_ABORT_UNLESS(controller->Initialize());
+        return controller;
+    }
+
+}
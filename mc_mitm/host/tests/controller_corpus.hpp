@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <memory>
+#include <span>
+#include "controllers/switch_controller.hpp"
+
+namespace ams::mitm::host::corpus {
+
+    constexpr bluetooth::Address test_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+
+    // An input report each supported controller translates, as it arrives from btdrv
+    struct ControllerCase {
+        const char *name;
+        controller::SwitchController *(*create)(const bluetooth::Address *address);
+        uint8_t id;
+        uint16_t size;
+    };
+
+    // Every corpus controller also implements this. It translates a report the way emulated controllers did before their decoders were
+    // resolved at compile time, for benchmarks to compare against
+    class BaselineDispatch {
+
+        public:
+            virtual Result HandleIncomingReportBaseline(const bluetooth::HidReport *report) = 0;
+
+    };
+
+    std::span<const ControllerCase> GetControllerCases(void);
+    std::unique_ptr<controller::SwitchController> CreateController(const ControllerCase &c, const bluetooth::Address *address = &test_address);
+
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_host.hpp"
+#include "controller_corpus.hpp"
+#include "controllers/xbox_one_controller.hpp"
+
+using namespace ams;
+using namespace ams::mitm::host::corpus;
+
+namespace {
+
+    // Feeds an Xbox One controller a 0x01 report of the given size with the button byte set, and returns the buttons it wrote to the fake buffer
+    uint32_t HandleXboxOneReport(controller::XboxOneController *controller, uint16_t size, uint8_t buttons) {
+        ams::mitm::host::runner::DrainInputReports();
+
+        bluetooth::HidReport report = {};
+        report.size = size;
+        auto xbox_report = reinterpret_cast<controller::XboxOneReportData *>(report.data);
+        xbox_report->id = 0x01;
+        reinterpret_cast<uint8_t *>(&xbox_report->input0x01.buttons)[1] = buttons;
+        controller->HandleIncomingReport(&report);
+
+        auto packet = bluetooth::hid::report::GetFakeBuffer()->Read();
+        if (packet == nullptr)
+            return 0;
+
+        auto written = reinterpret_cast<const controller::SwitchReportData *>(packet->data.data_report.v9.report.data);
+        auto mask = controller::ButtonDataToMask(&written->input0x30.buttons);
+        ams::mitm::host::runner::DrainInputReports();
+        return mask;
+    }
+
+}
+
+MC_TEST(controllers_write_one_report_per_input_report) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    for (auto &c : GetControllerCases()) {
+        auto controller = CreateController(c);
+        ams::mitm::host::runner::DrainInputReports();
+
+        bluetooth::HidReport report = {};
+        report.size = c.size;
+        report.data[0] = c.id;
+
+        for (size_t i = 0; i < 8; ++i) {
+            report.data[2] = uint8_t(i);
+            controller->HandleIncomingReport(&report);
+
+            auto written = ams::mitm::host::runner::DrainInputReports();
+            if (written != 1)
+                std::printf("    %s wrote %zu reports\n", c.name, written);
+            MC_CHECK_EQ(written, 1u);
+        }
+    }
+}
+
+MC_TEST(xbox_one_controller_rebinds_on_report_format_change) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    controller::XboxOneController controller(&test_address);
+
+    // Bit 3 of the first button byte is X on newer firmware, and Y on older firmware which sends shorter reports
+    constexpr uint16_t new_size = sizeof(controller::XboxOneInputReport0x01) + 1;
+    MC_CHECK_EQ(HandleXboxOneReport(&controller, new_size, 0x08), uint32_t(controller::SwitchButton_Y));
+    MC_CHECK_EQ(HandleXboxOneReport(&controller, new_size - 1, 0x08), uint32_t(controller::SwitchButton_X));
+    MC_CHECK_EQ(HandleXboxOneReport(&controller, new_size - 1, 0x08), uint32_t(controller::SwitchButton_X));
+    MC_CHECK_EQ(HandleXboxOneReport(&controller, new_size, 0x08), uint32_t(controller::SwitchButton_Y));
+}
+
+MC_TEST(controllers_match_baseline_dispatch) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    constexpr bluetooth::Address baseline_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x07}};
+
+    for (auto &c : GetControllerCases()) {
+        auto controller = CreateController(c);
+        auto baseline = CreateController(c, &baseline_address);
+        ams::mitm::host::runner::DrainInputReports();
+
+        bluetooth::HidReport report = {};
+        report.size = c.size;
+        report.data[0] = c.id;
+
+        for (size_t i = 0; i < 8; ++i) {
+            for (size_t j = 1; j < c.size; ++j)
+                report.data[j] = uint8_t(i * 0x35 + j);
+
+            bluetooth::HidReport written[2];
+            controller->HandleIncomingReport(&report);
+            dynamic_cast<BaselineDispatch *>(baseline.get())->HandleIncomingReportBaseline(&report);
+
+            for (auto &w : written) {
+                auto packet = bluetooth::hid::report::GetFakeBuffer()->Read();
+                MC_CHECK(packet != nullptr);
+                std::memcpy(&w, &packet->data.data_report.v9.report, sizeof(w));
+                bluetooth::hid::report::GetFakeBuffer()->Free();
+            }
+
+            // The decoded fields, battery through the sticks, must match. Motion is copied straight from the controller state
+            constexpr size_t offset = offsetof(controller::SwitchReportData, input0x30.timer) + 1;
+            constexpr size_t size = offsetof(controller::SwitchReportData, input0x30.vibrator) - offset;
+            bool match = (written[0].size == written[1].size) && (std::memcmp(&written[0].data[offset], &written[1].data[offset], size) == 0);
+            if (!match)
+                std::printf("    %s differs from its baseline\n", c.name);
+            MC_CHECK(match);
+        }
+    }
+}
+
+// Each report goes through the virtual HandleIncomingReport at the registry boundary, as it does in the report handler. The baseline is
+// the dispatch from before decoders were resolved at compile time. Per report it makes two indirect calls (HandleIncomingReport and
+// UpdateControllerState) and writes the button field of the outgoing report twice. The current path makes one indirect call and writes
+// the button field once
+MC_BENCHMARK(controller_dispatch) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    double total_baseline = 0;
+    double total = 0;
+    for (auto &c : GetControllerCases()) {
+        auto controller = CreateController(c);
+        auto baseline = dynamic_cast<BaselineDispatch *>(controller.get());
+
+        bluetooth::HidReport report = {};
+        report.size = c.size;
+        report.data[0] = c.id;
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s baseline", c.name);
+        total_baseline += ams::mitm::host::runner::Measure(label, 100000, [&](size_t i) {
+            report.data[2] = uint8_t(i);
+            baseline->HandleIncomingReportBaseline(&report);
+            ams::mitm::host::runner::DrainInputReports();
+        });
+
+        total += ams::mitm::host::runner::Measure(c.name, 100000, [&](size_t i) {
+            report.data[2] = uint8_t(i);
+            controller->HandleIncomingReport(&report);
+            ams::mitm::host::runner::DrainInputReports();
+        });
+    }
+
+    auto count = GetControllerCases().size();
+    std::printf("    %-48s %10.1f ns/op\n", "mean across controllers, baseline", total_baseline / count);
+    std::printf("    %-48s %10.1f ns/op\n", "mean across controllers", total / count);
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "report_load_generator.hpp"
+#include "controller_corpus.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_hid_report_dispatch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ams::mitm::host::load {
+
+    namespace {
+
+        constexpr size_t max_controllers = 16;
+
+        // Controller addresses end in their index, so the locator doesn't need a search
+        constexpr bluetooth::Address address_prefix = {{0x4c, 0x4f, 0x41, 0x44, 0x00, 0x00}};
+
+        struct SimulatedController {
+            bluetooth::Address address;
+            const corpus::ControllerCase *format;
+            std::unique_ptr<controller::SwitchController> controller;
+        };
+
+        bluetooth::CircularBuffer g_real_buffer;
+
+        // Stands in for the system event btdrv signals after writing to the real buffer
+        os::Event g_report_event(os::EventClearMode_AutoClear);
+
+        SimulatedController g_controllers[max_controllers];
+        size_t g_controller_count;
+
+        std::vector<u64> g_latencies;
+        size_t g_dispatched;
+
+        controller::SwitchController *LocateSimulatedController(const bluetooth::Address *address) {
+            auto index = address->address[5];
+            if (index >= g_controller_count)
+                return nullptr;
+
+            // The address handed to us lives in the packet just read from the real buffer, which carries the time btdrv wrote it.
+            // The packet has already been freed though, so skip the sample if btdrv has since written over it
+            auto packet = reinterpret_cast<const bluetooth::CircularBufferPacket *>(reinterpret_cast<const u8 *>(address) - offsetof(bluetooth::CircularBufferPacket, data.data_report.v9.addr));
+            auto type = packet->header.type;
+            auto timestamp = packet->header.timestamp;
+            auto now = os::GetSystemTick();
+            if ((type == BtdrvHidEventType_Data) && (timestamp <= now))
+                g_latencies.push_back(os::ConvertToTimeSpan(now - timestamp).GetNanoSeconds());
+
+            ++g_dispatched;
+
+            return g_controllers[index].controller.get();
+        }
+
+        bool WriteRealPacket(const SimulatedController *sim, u8 sequence, u64 *pending) {
+            auto format = sim->format;
+            auto rc = g_real_buffer.Write(BtdrvHidEventType_Data, format->size + 0x11, [&](bluetooth::HidReportEventInfo *event_info) {
+                std::memset(event_info, 0, offsetof(bluetooth::HidReportEventInfo, data_report.v9.report));
+                event_info->data_report.v9.addr = sim->address;
+
+                auto report = &event_info->data_report.v9.report;
+                std::memset(report, 0, sizeof(report->size) + format->size);
+                report->size = format->size;
+                report->data[0] = format->id;
+                report->data[2] = sequence;
+            }, pending);
+
+            return rc == 0;
+        }
+
+        u64 Percentile(const std::vector<u64> &sorted, double p) {
+            if (sorted.empty())
+                return 0;
+
+            return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+        }
+
+    }
+
+    LoadResult RunLoad(size_t controllers, u32 rate_hz, TimeSpan duration) {
+        AMS_ABORT_UNLESS(controllers <= max_controllers);
+
+        LoadResult result = {};
+
+        if (g_real_buffer.IsInitialized())
+            g_real_buffer.Finalize();
+        g_real_buffer.Initialize("HID Report");
+        g_real_buffer.type = bluetooth::CircularBufferType_HidReport;
+
+        // Cycle through every supported wire format
+        auto cases = corpus::GetControllerCases();
+        g_controller_count = controllers;
+        for (size_t i = 0; i < controllers; ++i) {
+            auto sim = &g_controllers[i];
+            sim->address = address_prefix;
+            sim->address.address[5] = i;
+            sim->format = &cases[i % cases.size()];
+            sim->controller = corpus::CreateController(*sim->format, &sim->address);
+        }
+
+        g_latencies.clear();
+        g_latencies.reserve(rate_hz ? controllers * rate_hz * (duration.GetMilliSeconds() / 1000 + 1) : 1 << 20);
+        g_dispatched = 0;
+
+        std::atomic<bool> stop = false;
+
+        // The report thread, translating whatever btdrv has written each time it is signalled
+        std::thread pipeline([&] {
+            while (!stop.load()) {
+                if (g_report_event.TimedWait(TimeSpan::FromMilliSeconds(1)))
+                    bluetooth::hid::report::ProcessReportBuffer(&g_real_buffer, bluetooth::hid::report::GetFakeBuffer(), LocateSimulatedController);
+            }
+        });
+
+        // Hid, reading back translated reports as they are forwarded
+        std::atomic<size_t> consumed = 0;
+        std::thread consumer([&] {
+            auto fake_buffer = bluetooth::hid::report::GetFakeBuffer();
+            while (true) {
+                bool stopping = stop.load();
+                bluetooth::hid::report::GetForwardEvent()->TimedWait(TimeSpan::FromMilliSeconds(1));
+
+                while (auto packet = fake_buffer->Read()) {
+                    if (packet->header.type != 0xff)
+                        consumed.fetch_add(1);
+                    fake_buffer->Free();
+                }
+
+                if (stopping)
+                    break;
+            }
+        });
+
+        // Btdrv, writing each controller's reports as they fall due. Controllers are spread evenly across the report period
+        auto start = os::GetSystemTick();
+        auto end = start + os::ConvertToTick(duration);
+        auto period = rate_hz ? os::ConvertToTick(TimeSpan::FromNanoSeconds(INT64_C(1000000000) / rate_hz)).GetInt64Value() : 0;
+
+        std::vector<s64> next_due(controllers);
+        for (size_t i = 0; i < controllers; ++i)
+            next_due[i] = start.GetInt64Value() + period * i / controllers;
+
+        u8 sequence = 0;
+        while (true) {
+            auto now = os::GetSystemTick();
+            if (now >= end)
+                break;
+
+            bool written = false;
+            s64 wake = end.GetInt64Value();
+            for (size_t i = 0; i < controllers; ++i) {
+                if (next_due[i] <= now.GetInt64Value()) {
+                    u64 pending = 0;
+                    if (WriteRealPacket(&g_controllers[i], ++sequence, &pending)) {
+                        ++result.offered;
+                        result.real_occupancy_max = std::max(result.real_occupancy_max, pending);
+                        written = true;
+                    }
+                    else {
+                        ++result.real_drops;
+                    }
+
+                    next_due[i] += period;
+                }
+
+                wake = std::min(wake, next_due[i]);
+            }
+
+            if (written)
+                g_report_event.Signal();
+
+            if (!period) {
+                // Unpaced, so back off only while the report thread makes room
+                if (!written)
+                    std::this_thread::yield();
+            }
+            else if (wake > os::GetSystemTick().GetInt64Value()) {
+                os::SleepThread(os::ConvertToTimeSpan(os::Tick(wake) - os::GetSystemTick()));
+            }
+        }
+
+        // Let the pipeline catch up with everything written before stopping
+        while ((g_real_buffer.GetWriteableSize() != bluetooth::BLUETOOTH_BUFFER_SIZE - 1) && (os::GetSystemTick() < end + os::ConvertToTick(TimeSpan::FromSeconds(1)))) {
+            g_report_event.Signal();
+            os::SleepThread(TimeSpan::FromMicroSeconds(100));
+        }
+        result.seconds = os::ConvertToTimeSpan(os::GetSystemTick() - start).GetNanoSeconds() / 1e9;
+
+        // Give hid a moment to read the last of the translated reports
+        os::SleepThread(TimeSpan::FromMilliSeconds(2));
+
+        stop = true;
+        pipeline.join();
+        consumer.join();
+
+        result.dispatched = g_dispatched;
+        result.consumed = consumed.load();
+
+        for (size_t i = 0; i < controllers; ++i) {
+            controller::ControllerStatistics stats;
+            g_controllers[i].controller->GetStats()->GetSnapshot(&stats);
+            result.fake_drops += stats.buffer_full_drops;
+            result.fake_occupancy_max = std::max<u64>(result.fake_occupancy_max, stats.buffer_occupancy_max);
+            g_controllers[i].controller.reset();
+        }
+
+        std::sort(g_latencies.begin(), g_latencies.end());
+        result.latency_p50_ns = Percentile(g_latencies, 0.50);
+        result.latency_p99_ns = Percentile(g_latencies, 0.99);
+        result.latency_max_ns = g_latencies.empty() ? 0 : g_latencies.back();
+
+        return result;
+    }
+
+    void PrintLoadResult(size_t controllers, u32 rate_hz, const LoadResult &result) {
+        char rate[16];
+        if (rate_hz)
+            std::snprintf(rate, sizeof(rate), "%u Hz", rate_hz);
+        else
+            std::snprintf(rate, sizeof(rate), "max");
+
+        std::printf("    %2zu x %-8s %9.0f reports/s  latency p50 %7.1f us  p99 %7.1f us  max %8.1f us  occupancy real %5" PRIu64 " fake %5" PRIu64 "  drops real %zu fake %zu\n",
+            controllers, rate, result.dispatched / result.seconds,
+            result.latency_p50_ns / 1e3, result.latency_p99_ns / 1e3, result.latency_max_ns / 1e3,
+            result.real_occupancy_max, result.fake_occupancy_max,
+            result.real_drops, result.fake_drops);
+    }
+
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+
+namespace ams::mitm::host::load {
+
+    struct LoadResult {
+        size_t offered;             // Reports btdrv wrote to the real buffer
+        size_t real_drops;          // Reports btdrv couldn't write because the real buffer was full
+        size_t dispatched;          // Reports handed to a controller for translation
+        size_t consumed;            // Translated reports read back by the fake hid consumer
+        size_t fake_drops;          // Translated reports dropped because the fake buffer was full
+        double seconds;
+        u64 latency_p50_ns;         // From a report landing in the real buffer until its controller picks it up
+        u64 latency_p99_ns;
+        u64 latency_max_ns;
+        u64 real_occupancy_max;     // Most bytes pending in the real buffer when btdrv wrote a report
+        u64 fake_occupancy_max;     // Most bytes pending in the fake buffer when a controller wrote a report
+    };
+
+    // Simulates controllers of every supported type each reporting at rate_hz, with btdrv writing their packets into a
+    // real buffer laid out as in shared memory and a fake hid consumer draining the translated reports. A rate of 0
+    // writes packets as fast as the real buffer accepts them
+    LoadResult RunLoad(size_t controllers, u32 rate_hz, TimeSpan duration);
+
+    void PrintLoadResult(size_t controllers, u32 rate_hz, const LoadResult &result);
+
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_hid_report_dispatch.hpp"
+#include <thread>
+
+namespace {
+
+    using namespace ams;
+    using namespace ams::bluetooth::hid::report;
+
+    constexpr auto read_timeout = TimeSpan::FromMilliSeconds(10);
+
+    struct ReadClient {
+        HidReportReadControl control = {};
+        os::SystemEvent user_event{os::EventClearMode_AutoClear, true};
+        os::SystemEvent read_event{os::EventClearMode_AutoClear, true};
+
+        bool HandOver(s64 *out_elapsed_ms) {
+            auto start = os::GetSystemTick();
+            auto read = HandOverReportEvents(&control, &user_event, &read_event, read_timeout);
+            *out_elapsed_ms = os::ConvertToTimeSpan(os::GetSystemTick() - start).GetMilliSeconds();
+            return read;
+        }
+
+        // Acknowledges the way a redirect client does, through the shared page and then the read event
+        void Acknowledge(void) {
+            control.consumed.store(control.produced.load(std::memory_order_acquire), std::memory_order_release);
+            read_event.Signal();
+        }
+    };
+
+}
+
+MC_TEST(report_read_acknowledged_through_shared_page) {
+    ReadClient client;
+
+    std::thread reader([&client] {
+        client.user_event.Wait();
+        client.Acknowledge();
+    });
+
+    s64 elapsed_ms;
+    MC_CHECK(client.HandOver(&elapsed_ms));
+    reader.join();
+
+    MC_CHECK_EQ(client.control.produced.load(), 1u);
+    MC_CHECK_EQ(client.control.consumed.load(), 1u);
+}
+
+MC_TEST(report_read_times_out_on_stalled_client) {
+    ReadClient client;
+
+    // The client never acknowledges, so the first batch waits out the timeout and no longer
+    s64 elapsed_ms;
+    MC_CHECK(!client.HandOver(&elapsed_ms));
+    MC_CHECK(elapsed_ms >= read_timeout.GetMilliSeconds());
+    MC_CHECK(elapsed_ms < 10 * read_timeout.GetMilliSeconds());
+    MC_CHECK_EQ(client.control.produced.load(), 1u);
+
+    // Later batches aren't handed over or waited on while it is still behind
+    client.user_event.Clear();
+    for (size_t i = 0; i < 8; ++i) {
+        MC_CHECK(!client.HandOver(&elapsed_ms));
+        MC_CHECK(elapsed_ms < read_timeout.GetMilliSeconds());
+    }
+    MC_CHECK_EQ(client.control.produced.load(), 1u);
+    MC_CHECK(!client.user_event.TryWait());
+
+    // Handing over resumes once the client catches up
+    client.Acknowledge();
+
+    std::thread reader([&client] {
+        client.user_event.Wait();
+        client.Acknowledge();
+    });
+
+    MC_CHECK(client.HandOver(&elapsed_ms));
+    reader.join();
+    MC_CHECK_EQ(client.control.produced.load(), 2u);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "report_load_generator.hpp"
+#include "controller_corpus.hpp"
+#include "mcmitm_host.hpp"
+
+using namespace ams;
+
+MC_TEST(load_generator_delivers_every_report) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    // Well within what the pipeline sustains, so nothing may be dropped along the way
+    auto result = ams::mitm::host::load::RunLoad(4, 125, TimeSpan::FromMilliSeconds(100));
+    ams::mitm::host::load::PrintLoadResult(4, 125, result);
+
+    MC_CHECK(result.offered > 0);
+    MC_CHECK_EQ(result.real_drops, 0u);
+    MC_CHECK_EQ(result.fake_drops, 0u);
+    MC_CHECK_EQ(result.dispatched, result.offered);
+    MC_CHECK_EQ(result.consumed, result.dispatched);
+}
+
+MC_TEST(buffer_occupancy_counts_reports_still_pending) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    auto &c = ams::mitm::host::corpus::GetControllerCases()[0];
+    auto controller = ams::mitm::host::corpus::CreateController(c);
+
+    bluetooth::HidReport report = {};
+    report.size = c.size;
+    report.data[0] = c.id;
+
+    // The first report finds the buffer empty, the second finds the first still waiting to be read
+    controller->HandleIncomingReport(&report);
+    auto packet = bluetooth::hid::report::GetFakeBuffer()->Read();
+    MC_CHECK(packet != nullptr);
+    auto pending = sizeof(packet->header) + packet->header.size;
+
+    controller->HandleIncomingReport(&report);
+    MC_CHECK_EQ(ams::mitm::host::runner::DrainInputReports(), 2u);
+
+    controller::ControllerStatistics stats;
+    controller->GetStats()->GetSnapshot(&stats);
+    MC_CHECK_EQ(stats.buffer_occupancy_max, pending);
+}
+
+// Controllers x report rate sweeps, each run for 250ms of wall time
+MC_BENCHMARK(report_pipeline_scaling) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    for (size_t controllers : {1, 2, 4, 8}) {
+        for (u32 rate_hz : {125, 250, 500, 1000}) {
+            auto result = ams::mitm::host::load::RunLoad(controllers, rate_hz, TimeSpan::FromMilliSeconds(250));
+            ams::mitm::host::load::PrintLoadResult(controllers, rate_hz, result);
+        }
+    }
+}
+
+// Btdrv writing as fast as the real buffer accepts, for the most reports the pipeline can translate
+MC_BENCHMARK(report_pipeline_saturation) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    for (size_t controllers : {1, 4, 8, 16}) {
+        auto result = ams::mitm::host::load::RunLoad(controllers, 0, TimeSpan::FromMilliSeconds(250));
+        ams::mitm::host::load::PrintLoadResult(controllers, 0, result);
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_host.hpp"
+#include "controllers/dualshock4_controller.hpp"
+#include "controllers/dualsense_controller.hpp"
+#include <cstdlib>
+
+namespace {
+
+    using namespace ams;
+
+    constexpr bluetooth::Address test_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+
+    size_t g_output_reports;
+    size_t g_bad_crcs;
+
+    // The crc of Sony bluetooth output reports covers the 0xa2 transaction header, which isn't part of the sent report
+    void CheckOutputReportCrc(const bluetooth::Address *address, const bluetooth::HidReport *report) {
+        uint8_t buffer[sizeof(report->data) + 1];
+        buffer[0] = 0xa2;
+        std::memcpy(&buffer[1], report->data, report->size - sizeof(uint32_t));
+
+        uint32_t crc;
+        std::memcpy(&crc, &report->data[report->size - sizeof(uint32_t)], sizeof(crc));
+
+        ++g_output_reports;
+        if (crc != crc32Calculate(buffer, report->size - sizeof(uint32_t) + 1))
+            ++g_bad_crcs;
+    }
+
+    template <typename T>
+    void SendOutputReports(void) {
+        T controller(&test_address);
+        R_ABORT_UNLESS(controller.Initialize());
+
+        const controller::SwitchRumbleData rumble = {100, 0.5f, 200, 0.25f};
+        controller.SetVibration(&rumble);
+        controller.SetPlayerLed(0x3);
+        controller.CancelVibration();
+    }
+
+}
+
+MC_TEST(crc32_update_matches_crc32Calculate) {
+    std::srand(0);
+
+    uint8_t data[0x200];
+    for (auto &b : data)
+        b = std::rand();
+
+    for (size_t size = 0; size < sizeof(data); ++size) {
+        auto expected = crc32Calculate(data, size);
+        MC_CHECK_EQ(~controller::crc32_update(controller::crc32_initial_state, data, size), expected);
+
+        // Resuming from any split point must give the same crc
+        auto split = size ? std::rand() % size : 0;
+        auto state = controller::crc32_update(controller::crc32_initial_state, data, split);
+        MC_CHECK_EQ(~controller::crc32_update(state, &data[split], size - split), expected);
+    }
+}
+
+MC_TEST(sony_output_reports_carry_valid_crc) {
+    g_output_reports = 0;
+    g_bad_crcs = 0;
+    ams::mitm::host::SetOutputReportHandler(CheckOutputReportCrc);
+    ON_SCOPE_EXIT { ams::mitm::host::SetOutputReportHandler(nullptr); };
+
+    SendOutputReports<controller::Dualshock4Controller>();
+    SendOutputReports<controller::DualsenseController>();
+
+    MC_CHECK(g_output_reports > 0);
+    MC_CHECK_EQ(g_bad_crcs, 0u);
+}
+
+MC_TEST(sony_output_reports_count_only_suppressed_rumble) {
+    controller::Dualshock4Controller controller(&test_address);
+    R_ABORT_UNLESS(controller.Initialize());
+
+    auto suppressed = [&](void) {
+        controller::ControllerStatistics stats;
+        controller.GetStats()->GetSnapshot(&stats);
+        return stats.rumble_suppressed;
+    };
+
+    // Repeating the led state sends nothing, but no rumble was dropped
+    controller.SetPlayerLed(0x1);
+    controller.SetPlayerLed(0x1);
+    MC_CHECK_EQ(suppressed(), 0u);
+
+    const controller::SwitchRumbleData rumble = {100, 0.5f, 200, 0.25f};
+    controller.SetVibration(&rumble);
+    MC_CHECK_EQ(suppressed(), 0u);
+    controller.SetVibration(&rumble);
+    MC_CHECK_EQ(suppressed(), 1u);
+}
+
+MC_BENCHMARK(sony_output_report_crc) {
+    // The host crc32Calculate is a bitwise reference implementation, so only the table driven crc and Build costs compare directly
+    controller::SonyOutputReport<controller::Dualshock4OutputReport0x11> report;
+    const uint8_t header[] = {0xa2, 0x11, 0xc0, 0x20, 0xf3, 0x04, 0x00};
+    report.SetHeader(header, sizeof(header));
+
+    bluetooth::HidReport out;
+    uint8_t buffer[sizeof(controller::Dualshock4OutputReport0x11)];
+
+    ams::mitm::host::runner::Measure("crc32Calculate over the full report", 100000, [&](size_t i) {
+        buffer[8] = uint8_t(i);
+        volatile auto crc = crc32Calculate(buffer, sizeof(buffer) - sizeof(uint32_t));
+        (void)crc;
+    });
+
+    ams::mitm::host::runner::Measure("crc32_update over the full report", 100000, [&](size_t i) {
+        buffer[8] = uint8_t(i);
+        volatile auto crc = ~controller::crc32_update(controller::crc32_initial_state, buffer, sizeof(buffer) - sizeof(uint32_t));
+        (void)crc;
+    });
+
+    ams::mitm::host::runner::Measure("SonyOutputReport::Build", 100000, [&](size_t i) {
+        report.Set(8, uint8_t(i));
+        report.Build(&out);
+    });
+}
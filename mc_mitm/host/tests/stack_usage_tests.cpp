@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_host.hpp"
+#include "mcmitm_utils.hpp"
+#include "controller_corpus.hpp"
+#include <cstring>
+#include <vector>
+#include <ucontext.h>
+
+namespace {
+
+    using namespace ams;
+    using namespace ams::mitm::host::corpus;
+
+    // Stack of the hid report thread on the console, which runs every path replayed here. Part of it is kept back for
+    // the thread's own event loop and for frames being larger on the console than on the host
+    constexpr size_t report_thread_stack_size = 0x1000;
+    constexpr size_t report_thread_stack_budget = report_thread_stack_size - 0x400;
+
+    // Replayed on a much larger stack so an overrun is measured rather than crashing the runner
+    alignas(0x1000) uint8_t g_replay_stack[0x10000];
+    ucontext_t g_runner_context;
+    ucontext_t g_replay_context;
+
+    std::vector<std::unique_ptr<controller::SwitchController>> g_controllers;
+
+    void SendSubCmd(controller::SwitchController *controller, controller::SubCmdType id) {
+        bluetooth::HidReport report = {};
+        report.size = 0x31;
+        report.data[0] = 0x01;
+
+        auto switch_report = reinterpret_cast<controller::SwitchReportData *>(report.data);
+        switch_report->output0x01.subcmd.id = id;
+        controller->HandleOutgoingReport(&report);
+    }
+
+    // Every input and output path the report thread takes for each supported controller
+    void ReplayCorpus(void) {
+        for (size_t i = 0; i < g_controllers.size(); ++i) {
+            auto &c = GetControllerCases()[i];
+            auto controller = g_controllers[i].get();
+
+            bluetooth::HidReport report = {};
+            report.size = c.size;
+            report.data[0] = c.id;
+            controller->HandleIncomingReport(&report);
+
+            const uint8_t rumble[] = {0x10, 0x00, 0x28, 0x88, 0x60, 0x61, 0x28, 0x88, 0x60, 0x61};
+            report.size = sizeof(rumble);
+            std::memcpy(report.data, rumble, sizeof(rumble));
+            controller->HandleOutgoingReport(&report);
+
+            SendSubCmd(controller, controller::SubCmd_RequestDeviceInfo);
+            SendSubCmd(controller, controller::SubCmd_SpiFlashRead);
+            SendSubCmd(controller, controller::SubCmd_SetInputReportMode);
+            SendSubCmd(controller, controller::SubCmd_SetPlayerLeds);
+            SendSubCmd(controller, controller::SubCmd_EnableVibration);
+            SendSubCmd(controller, controller::SubCmd_EnableImu);
+
+            ams::mitm::host::runner::DrainInputReports();
+        }
+    }
+
+}
+
+MC_TEST(report_paths_fit_report_thread_stack) {
+    ams::mitm::host::SetOutputReportHandler(nullptr);
+
+    // Controllers are created on the events thread on the console, so only the report paths are replayed on the painted stack
+    for (auto &c : GetControllerCases())
+        g_controllers.push_back(CreateController(c));
+    ON_SCOPE_EXIT { g_controllers.clear(); };
+
+    // Warm up on the runner's stack first, so one-off costs like lazy symbol binding in shared libraries aren't measured
+    ReplayCorpus();
+
+    mitm::utils::PaintThreadStack("replay", g_replay_stack, sizeof(g_replay_stack));
+
+    getcontext(&g_replay_context);
+    g_replay_context.uc_stack.ss_sp = g_replay_stack;
+    g_replay_context.uc_stack.ss_size = sizeof(g_replay_stack);
+    g_replay_context.uc_link = &g_runner_context;
+    makecontext(&g_replay_context, ReplayCorpus, 0);
+    swapcontext(&g_runner_context, &g_replay_context);
+
+    mitm::utils::ThreadStackUsage usage[mitm::utils::MaxTrackedThreadStacks];
+    auto count = mitm::utils::GetThreadStackUsage(usage, std::size(usage));
+
+    size_t high_water_mark = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (std::strcmp(usage[i].name, "replay") == 0)
+            high_water_mark = usage[i].high_water_mark;
+    }
+
+    std::printf("    deepest report path used 0x%zx bytes of stack, budget 0x%zx\n", high_water_mark, report_thread_stack_budget);
+    MC_CHECK(high_water_mark > 0);
+    MC_CHECK(high_water_mark <= report_thread_stack_budget);
+}
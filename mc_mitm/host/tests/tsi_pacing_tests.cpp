@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_config.hpp"
+#include "controllers/xbox_one_controller.hpp"
+
+namespace {
+
+    using namespace ams;
+
+    constexpr bluetooth::Address test_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+
+    // Feeds an input report every millisecond for 100ms and counts the reports written to the fake buffer
+    size_t CountReportsAtTsi(bool tsi_pacing, uint8_t tsi) {
+        ams::mitm::host::runner::WriteConfig(tsi_pacing ? "[profile:default]\ntsi_pacing=true\n" : "");
+
+        auto config = mitm::AcquireConfig();
+        ON_SCOPE_EXIT { mitm::ReleaseConfig(config); };
+
+        controller::XboxOneController controller(&test_address);
+        controller.SetProfile(config, mitm::FindControllerProfile(config, &test_address, 0x045e, 0x02e0));
+        R_ABORT_UNLESS(controller.Initialize());
+        controller.SetTsi(tsi);
+
+        bluetooth::HidReport report = {};
+        report.size = sizeof(controller::XboxOneInputReport0x01) + 1;
+        report.data[0] = 0x01;
+
+        size_t count = 0;
+        for (size_t i = 0; i < 100; ++i) {
+            controller.HandleIncomingReport(&report);
+            count += ams::mitm::host::runner::DrainInputReports();
+            os::SleepThread(TimeSpan::FromMilliSeconds(1));
+        }
+
+        return count;
+    }
+
+}
+
+MC_TEST(tsi_ignored_unless_enabled_by_profile) {
+    MC_CHECK_EQ(CountReportsAtTsi(false, 10), 100u);
+}
+
+MC_TEST(tsi_paces_reports_when_enabled_by_profile) {
+    MC_CHECK_EQ(CountReportsAtTsi(true, 0xff), 100u);
+
+    // Tsi 10 paces reports to 30ms, so 100ms of input gives at most 4 of them
+    auto count = CountReportsAtTsi(true, 10);
+    std::printf("    %zu reports at tsi 10\n", count);
+    MC_CHECK(count > 0 && count <= 4);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "virtual_controller_client.hpp"
+
+namespace ams::mitm::host::client {
+
+    VirtualControllerClient::VirtualControllerClient(Handle shmem_handle, os::SystemEvent *input_event)
+    : m_shmem({})
+    , m_rings(nullptr)
+    , m_input_event(input_event) {
+        shmemLoadRemote(&m_shmem, shmem_handle, sizeof(controller::VirtualControllerSharedMemory), Perm_Rw);
+    }
+
+    VirtualControllerClient::~VirtualControllerClient(void) {
+        if (m_rings)
+            shmemClose(&m_shmem);
+    }
+
+    Result VirtualControllerClient::Connect(void) {
+        R_TRY(shmemMap(&m_shmem));
+        m_rings = reinterpret_cast<controller::VirtualControllerSharedMemory *>(shmemGetAddr(&m_shmem));
+
+        return ams::ResultSuccess();
+    }
+
+    bool VirtualControllerClient::SendInput(const controller::VirtualControllerInputFrame *frame) {
+        if (!m_rings->input.Push(frame))
+            return false;
+
+        // A real client signals the writable handle it was given, waking the report thread
+        m_input_event->Signal();
+
+        return true;
+    }
+
+    bool VirtualControllerClient::ReceiveOutput(controller::VirtualControllerOutputFrame *frame) {
+        return m_rings->output.Pop(frame);
+    }
+
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include "controllers/virtual_controller.hpp"
+
+namespace ams::mitm::host::client {
+
+    // Stands in for a homebrew client driving a virtual controller through the handles returned by CreateVirtualController
+    class VirtualControllerClient {
+
+        public:
+            VirtualControllerClient(Handle shmem_handle, os::SystemEvent *input_event);
+            ~VirtualControllerClient(void);
+
+            Result Connect(void);
+            bool SendInput(const controller::VirtualControllerInputFrame *frame);
+            bool ReceiveOutput(controller::VirtualControllerOutputFrame *frame);
+
+            // Direct access to the rings, for clients that don't play by the rules
+            controller::VirtualControllerSharedMemory *GetRings(void) { return m_rings; }
+
+        private:
+            SharedMemory m_shmem;
+            controller::VirtualControllerSharedMemory *m_rings;
+            os::SystemEvent *m_input_event;
+    };
+
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "virtual_controller_client.hpp"
+#include "mcmitm_config.hpp"
+#include <memory>
+
+namespace {
+
+    using namespace ams;
+
+    constexpr bluetooth::Address virtual_address = controller::VirtualController::address_prefix;
+
+    struct VirtualControllerFixture {
+        const mitm::MissionControlConfig *config;
+        controller::VirtualController controller;
+        std::unique_ptr<mitm::host::client::VirtualControllerClient> client;
+
+        VirtualControllerFixture(void)
+        : config(mitm::AcquireConfig())
+        , controller(&virtual_address) {
+            R_ABORT_UNLESS(controller.Initialize());
+            controller.SetProfile(config, mitm::FindControllerProfile(config, &virtual_address, 0, 0));
+
+            client = std::make_unique<mitm::host::client::VirtualControllerClient>(controller.GetSharedMemoryHandle(), controller::GetVirtualInputEvent());
+            R_ABORT_UNLESS(client->Connect());
+            controller::GetVirtualInputEvent()->Clear();
+        }
+
+        ~VirtualControllerFixture(void) {
+            mitm::ReleaseConfig(config);
+        }
+    };
+
+}
+
+MC_TEST(virtual_controller_reports_client_input) {
+    VirtualControllerFixture fixture;
+
+    controller::VirtualControllerInputFrame frame = {};
+    frame.buttons = 1;
+    frame.left_stick_x = frame.left_stick_y = 0x800;
+    frame.right_stick_x = frame.right_stick_y = 0x800;
+    MC_CHECK(fixture.client->SendInput(&frame));
+
+    // The write wakes the report thread, which then drains the ring
+    MC_CHECK(controller::GetVirtualInputEvent()->TryWait());
+
+    os::Tick deadline;
+    MC_CHECK(!fixture.controller.ServicePacing(os::GetSystemTick(), &deadline));
+    MC_CHECK_EQ(ams::mitm::host::runner::DrainInputReports(), 1u);
+}
+
+MC_TEST(virtual_controller_idle_needs_no_wakeups) {
+    VirtualControllerFixture fixture;
+
+    // Without pacing there is no deadline to poll the ring by, and nothing is reported until the client writes
+    os::Tick deadline;
+    MC_CHECK(!fixture.controller.ServicePacing(os::GetSystemTick(), &deadline));
+    MC_CHECK_EQ(ams::mitm::host::runner::DrainInputReports(), 0u);
+    MC_CHECK(!controller::GetVirtualInputEvent()->TryWait());
+}
+
+MC_TEST(virtual_controller_forwards_player_leds_to_client) {
+    VirtualControllerFixture fixture;
+
+    bluetooth::HidReport report = {};
+    report.size = 49;
+    report.data[0] = 0x01;
+    report.data[10] = controller::SubCmd_SetPlayerLeds;
+    report.data[11] = 0x05;
+    MC_CHECK(R_SUCCEEDED(fixture.controller.HandleOutgoingReport(&report)));
+
+    controller::VirtualControllerOutputFrame frame;
+    MC_CHECK(fixture.client->ReceiveOutput(&frame));
+    MC_CHECK_EQ(frame.type, controller::VirtualControllerOutput_PlayerLed);
+    MC_CHECK_EQ(frame.led_mask, 0x05);
+    MC_CHECK(!fixture.client->ReceiveOutput(&frame));
+}
+
+MC_TEST(virtual_controller_discards_corrupt_input_ring) {
+    VirtualControllerFixture fixture;
+
+    controller::VirtualControllerInputFrame frame = {};
+    frame.buttons = 1;
+    MC_CHECK(fixture.client->SendInput(&frame));
+
+    // A head claiming about 4 billion queued frames must not be drained one by one
+    auto rings = fixture.client->GetRings();
+    rings->input.head.store(rings->input.tail.load() + 0xffffffff);
+
+    auto start = os::GetSystemTick();
+    os::Tick deadline;
+    fixture.controller.ServicePacing(os::GetSystemTick(), &deadline);
+    MC_CHECK(os::ConvertToTimeSpan(os::GetSystemTick() - start).GetMilliSeconds() < 10);
+
+    MC_CHECK_EQ(rings->input.Pending(), 0u);
+    MC_CHECK_EQ(ams::mitm::host::runner::DrainInputReports(), 0u);
+
+    // The ring is usable again afterwards
+    MC_CHECK(fixture.client->SendInput(&frame));
+    fixture.controller.ServicePacing(os::GetSystemTick(), &deadline);
+    MC_CHECK_EQ(ams::mitm::host::runner::DrainInputReports(), 1u);
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runner/runner.hpp"
+#include "mcmitm_host.hpp"
+#include "mcmitm_config.hpp"
+#include "controllers/xbox_one_controller.hpp"
+#include "controllers/load_governor.hpp"
+
+namespace {
+
+    using namespace ams;
+
+    constexpr bluetooth::Address test_address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+
+    size_t g_rumble_commands;
+    size_t g_stop_commands;
+
+    void CountRumbleCommands(const bluetooth::Address *address, const bluetooth::HidReport *report) {
+        auto xbox_report = reinterpret_cast<const controller::XboxOneReportData *>(report->data);
+        if (xbox_report->id != 0x03)
+            return;
+
+        ++g_rumble_commands;
+        if (xbox_report->output0x03.pulse_sustain_10ms == 0)
+            ++g_stop_commands;
+    }
+
+    // Console rumble packet with only the low band of the left motor set
+    bluetooth::HidReport MakeRumblePacket(uint8_t amplitude) {
+        bluetooth::HidReport report = {};
+        report.size = sizeof(controller::SwitchOutputReport0x10) + 1;
+
+        auto switch_report = reinterpret_cast<controller::SwitchReportData *>(report.data);
+        switch_report->id = 0x10;
+        switch_report->output0x10.left_motor[2] = 0x01;
+        switch_report->output0x10.left_motor[3] = 0x40 + amplitude;
+
+        return report;
+    }
+
+    // Feed the governor fully busy windows until it reaches the given level
+    void ForceLoadLevel(controller::LoadLevel level) {
+        controller::SetLoadBudget(level == controller::LoadLevel_Full ? 0 : 50);
+
+        auto start = os::GetSystemTick();
+        while (controller::GetLoadLevel() != level) {
+            auto end = start + os::ConvertToTick(TimeSpan::FromMilliSeconds(300));
+            controller::RecordTranslationWork(start, end);
+            start = end;
+        }
+    }
+
+}
+
+MC_TEST(xbox_one_rumble_commands_are_scheduled) {
+    g_rumble_commands = 0;
+    g_stop_commands = 0;
+    ams::mitm::host::SetOutputReportHandler(CountRumbleCommands);
+    ON_SCOPE_EXIT { ams::mitm::host::SetOutputReportHandler(nullptr); };
+
+    auto config = mitm::AcquireConfig();
+    ON_SCOPE_EXIT { mitm::ReleaseConfig(config); };
+
+    controller::XboxOneController controller(&test_address);
+    controller.SetProfile(config, nullptr);
+    R_ABORT_UNLESS(controller.Initialize());
+
+    // The console streams the same rumble state every 15ms for about a second, then stops it
+    const controller::SwitchRumbleData on = {160.0f, 0.5f, 320.0f, 0.25f};
+    const controller::SwitchRumbleData off = {160.0f, 0.0f, 320.0f, 0.0f};
+    for (size_t i = 0; i < 80; ++i) {
+        controller.SetVibration(i < 66 ? &on : &off);
+        os::SleepThread(TimeSpan::FromMilliSeconds(15));
+    }
+
+    // A command every 200ms to keep the 250ms pulse running, rather than one per packet, and a single stop
+    std::printf("    %zu rumble commands for 80 packets\n", g_rumble_commands);
+    MC_CHECK(g_rumble_commands >= 5 && g_rumble_commands <= 7);
+    MC_CHECK_EQ(g_stop_commands, 1u);
+}
+
+MC_TEST(rumble_deferred_under_load_is_flushed) {
+    g_rumble_commands = 0;
+    g_stop_commands = 0;
+    ams::mitm::host::SetOutputReportHandler(CountRumbleCommands);
+    ON_SCOPE_EXIT { ams::mitm::host::SetOutputReportHandler(nullptr); };
+
+    auto config = mitm::AcquireConfig();
+    ON_SCOPE_EXIT { mitm::ReleaseConfig(config); };
+
+    controller::XboxOneController controller(&test_address);
+    controller.SetProfile(config, nullptr);
+    R_ABORT_UNLESS(controller.Initialize());
+
+    ForceLoadLevel(controller::LoadLevel_Reduced);
+    ON_SCOPE_EXIT { ForceLoadLevel(controller::LoadLevel_Full); };
+
+    // Only the first update goes out straight away. The last of the others is held back rather than dropped
+    for (uint8_t amplitude : {10, 20, 30}) {
+        auto report = MakeRumblePacket(amplitude);
+        controller.HandleOutgoingReport(&report);
+    }
+    MC_CHECK_EQ(g_rumble_commands, 1u);
+
+    os::Tick deadline;
+    MC_CHECK(controller.ServicePacing(os::GetSystemTick(), &deadline));
+
+    os::SleepThread(os::ConvertToTimeSpan(deadline - os::GetSystemTick()) + TimeSpan::FromMilliSeconds(1));
+    controller.ServicePacing(os::GetSystemTick(), &deadline);
+    MC_CHECK_EQ(g_rumble_commands, 2u);
+
+    // Nothing is left to flush, and a stop is never held back
+    MC_CHECK(!controller.ServicePacing(os::GetSystemTick(), &deadline));
+
+    auto stop = MakeRumblePacket(0);
+    controller.HandleOutgoingReport(&stop);
+    MC_CHECK_EQ(g_rumble_commands, 3u);
+    MC_CHECK_EQ(g_stop_commands, 1u);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bluetooth_adapter.hpp"
+#include <mutex>
+#include <cstring>
+#include <algorithm>
+
+namespace ams::bluetooth::adapter {
+
+    namespace {
+
+        os::SdkMutex g_adapter_lock;
+        bool g_loaded;
+
+        bluetooth::Address g_address;
+        bluetooth::Address g_wii_pin;
+        char g_name[MaxNameLength + 1];
+
+        void UpdateAddress(const bluetooth::Address *address) {
+            g_address = *address;
+
+            for (size_t i = 0; i < sizeof(bluetooth::Address); ++i)
+                g_wii_pin.address[i] = g_address.address[sizeof(bluetooth::Address) - 1 - i];
+        }
+
+        void UpdateName(const char *name, size_t length) {
+            length = std::min(length, MaxNameLength);
+            std::memcpy(g_name, name, length);
+            g_name[length] = '\0';
+        }
+
+        Result LoadProperties(void) {
+            bluetooth::Address address;
+            if (hos::GetVersion() < hos::Version_12_0_0) {
+                char name[MaxNameLength] = {};
+                R_TRY(btdrvLegacyGetAdapterProperty(BtdrvBluetoothPropertyType_Address, &address, sizeof(bluetooth::Address)));
+                R_TRY(btdrvLegacyGetAdapterProperty(BtdrvBluetoothPropertyType_Name, name, sizeof(name)));
+                UpdateName(name, strnlen(name, sizeof(name)));
+            }
+            else {
+                BtdrvAdapterProperty property;
+                R_TRY(btdrvGetAdapterProperty(BtdrvAdapterPropertyType_Address, &property));
+                std::memcpy(&address, property.data, sizeof(bluetooth::Address));
+                R_TRY(btdrvGetAdapterProperty(BtdrvAdapterPropertyType_Name, &property));
+                UpdateName(reinterpret_cast<const char *>(property.data), strnlen(reinterpret_cast<const char *>(property.data), property.size));
+            }
+
+            UpdateAddress(&address);
+            g_loaded = true;
+
+            return ams::ResultSuccess();
+        }
+
+        // Properties are normally loaded at startup, but fall back to fetching them if something needs them sooner
+        void EnsureLoaded(void) {
+            if (!g_loaded)
+                R_ABORT_UNLESS(LoadProperties());
+        }
+
+    }
+
+    Result Initialize(void) {
+        std::scoped_lock lk(g_adapter_lock);
+
+        return LoadProperties();
+    }
+
+    Result SetAddress(const bluetooth::Address *address) {
+        std::scoped_lock lk(g_adapter_lock);
+
+        if (hos::GetVersion() < hos::Version_12_0_0) {
+            R_TRY(btdrvLegacySetAdapterProperty(BtdrvBluetoothPropertyType_Address, address, sizeof(bluetooth::Address)));
+        }
+        else {
+            BtdrvAdapterProperty property;
+            property.type = BtdrvAdapterPropertyType_Address;
+            property.size = sizeof(bluetooth::Address);
+            std::memcpy(property.data, address, sizeof(bluetooth::Address));
+            R_TRY(btdrvSetAdapterProperty(BtdrvAdapterPropertyType_Address, &property));
+        }
+
+        UpdateAddress(address);
+
+        return ams::ResultSuccess();
+    }
+
+    Result SetName(const char *name) {
+        std::scoped_lock lk(g_adapter_lock);
+
+        auto length = strnlen(name, MaxNameLength);
+        if (hos::GetVersion() < hos::Version_12_0_0) {
+            R_TRY(btdrvLegacySetAdapterProperty(BtdrvBluetoothPropertyType_Name, name, length));
+        }
+        else {
+            BtdrvAdapterProperty property;
+            property.type = BtdrvAdapterPropertyType_Name;
+            property.size = length;
+            std::memcpy(property.data, name, length);
+            R_TRY(btdrvSetAdapterProperty(BtdrvAdapterPropertyType_Name, &property));
+        }
+
+        UpdateName(name, length);
+
+        return ams::ResultSuccess();
+    }
+
+    void GetAddress(bluetooth::Address *out) {
+        std::scoped_lock lk(g_adapter_lock);
+        EnsureLoaded();
+
+        *out = g_address;
+    }
+
+    void GetName(char *out, size_t size) {
+        std::scoped_lock lk(g_adapter_lock);
+        EnsureLoaded();
+
+        std::strncpy(out, g_name, size - 1);
+        out[size - 1] = '\0';
+    }
+
+    size_t GetWiiPinCode(void *out) {
+        std::scoped_lock lk(g_adapter_lock);
+        EnsureLoaded();
+
+        std::memcpy(out, &g_wii_pin, sizeof(bluetooth::Address));
+        return sizeof(bluetooth::Address);
+    }
+
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include "bluetooth_types.hpp"
+
+namespace ams::bluetooth::adapter {
+
+    constexpr size_t MaxNameLength = 0xf8;
+
+    // Properties are fetched from btdrv once after bluetooth is enabled, and kept up to date when we change them ourselves
+    Result Initialize(void);
+
+    Result SetAddress(const bluetooth::Address *address);
+    Result SetName(const char *name);
+
+    void GetAddress(bluetooth::Address *out);
+    void GetName(char *out, size_t size);
+
+    // Wii devices pair using the host address in reverse byte order as their pin
+    size_t GetWiiPinCode(void *out);
+
+}
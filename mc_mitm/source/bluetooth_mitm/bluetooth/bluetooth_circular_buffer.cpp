@@ -85,7 +85,7 @@ namespace ams::bluetooth {
                 os::SignalEvent(this->event);
         };
 
-        if (size + sizeof(CircularBufferPacketHeader) <= this->GetWriteableSize()) {
+        if (this->_hasSpaceFor(size)) {
             if (size + 2*sizeof(CircularBufferPacketHeader) > BLUETOOTH_BUFFER_SIZE - this->writeOffset) {
                 R_TRY(this->_write(0xff, nullptr, (BLUETOOTH_BUFFER_SIZE - this->writeOffset) - sizeof(CircularBufferPacketHeader)));
             }
@@ -171,11 +171,17 @@ namespace ams::bluetooth {
         return this->readOffset;
     }
 
+    bool CircularBuffer::_hasSpaceFor(size_t size) {
+        // Packets that won't fit before the end of the buffer are written at the start after padding out the remainder,
+        // so the reader must already be past the padding and leave room for the packet at the start
+        if (size + 2*sizeof(CircularBufferPacketHeader) > BLUETOOTH_BUFFER_SIZE - this->writeOffset)
+            return (this->readOffset <= this->writeOffset) && (size + sizeof(CircularBufferPacketHeader) < this->readOffset);
+
+        return size + sizeof(CircularBufferPacketHeader) <= this->GetWriteableSize();
+    }
+
     u64 CircularBuffer::_write(u8 type, void *data, size_t size) {
-        auto packet = reinterpret_cast<CircularBufferPacket *>(&this->data[this->writeOffset]);
-        packet->header.type = type;
-        packet->header.timestamp = os::GetSystemTick();
-        packet->header.size = size;
+        auto packet = this->_reserve(type, size);
 
         if (type != 0xff) {
             if (data && (size > 0))
@@ -184,6 +190,19 @@ namespace ams::bluetooth {
                 return -1;
         }
 
+        return this->_commit(size);
+    }
+
+    CircularBufferPacket *CircularBuffer::_reserve(u8 type, size_t size) {
+        auto packet = reinterpret_cast<CircularBufferPacket *>(&this->data[this->writeOffset]);
+        packet->header.type = type;
+        packet->header.timestamp = os::GetSystemTick();
+        packet->header.size = size;
+
+        return packet;
+    }
+
+    u64 CircularBuffer::_commit(size_t size) {
         u32 newOffset = this->writeOffset + size + sizeof(CircularBufferPacketHeader);
         if (newOffset > BLUETOOTH_BUFFER_SIZE)
             return -1;
@@ -16,6 +16,7 @@
 #pragma once
 #include <switch.h>
 #include <stratosphere.hpp>
+#include <mutex>
 
 #include "bluetooth_types.hpp"
 
@@ -54,6 +55,40 @@ namespace ams::bluetooth {
             u64 GetWriteableSize(void);
             void SetWriteCompleteEvent(os::EventType *event);
             u64 Write(u8 type, void *data, size_t size);
+
+            // Reserves a packet of the given size and lets the caller populate it in place, avoiding an intermediate copy.
+            // If requested, the bytes still pending from earlier writes are sampled under the lock before the packet is added
+            template <typename F>
+            u64 Write(u8 type, size_t size, F populate, u64 *out_pending = nullptr) {
+                if (!this->isInitialized)
+                    return -1;
+
+                std::scoped_lock lk(this->mutex);
+
+                if (out_pending)
+                    *out_pending = (BLUETOOTH_BUFFER_SIZE - 1) - this->GetWriteableSize();
+
+                ON_SCOPE_EXIT {
+                    if (this->event)
+                        os::SignalEvent(this->event);
+                };
+
+                if (this->_hasSpaceFor(size)) {
+                    if (size + 2*sizeof(CircularBufferPacketHeader) > BLUETOOTH_BUFFER_SIZE - this->writeOffset) {
+                        R_TRY(this->_write(0xff, nullptr, (BLUETOOTH_BUFFER_SIZE - this->writeOffset) - sizeof(CircularBufferPacketHeader)));
+                    }
+
+                    auto packet = this->_reserve(type, size);
+                    populate(&packet->data);
+                    R_TRY(this->_commit(size));
+                    this->_updateUtilization();
+
+                    return 0;
+                }
+
+                return -1;
+            }
+
             void DiscardOldPackets(u8 type, u32 ageLimit);
             CircularBufferPacket *Read(void);
             u64 Free(void);
@@ -63,7 +98,10 @@ namespace ams::bluetooth {
             void _setWriteOffset(u32 offset);
             u32  _getWriteOffset(void);
             u32  _getReadOffset(void);
+            bool _hasSpaceFor(size_t size);
             u64  _write(u8 type, void *data, size_t size);
+            CircularBufferPacket *_reserve(u8 type, size_t size);
+            u64  _commit(size_t size);
             void _updateUtilization(void);
             CircularBufferPacket *_read(void);
 
@@ -14,8 +14,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "bluetooth_core.hpp"
+#include "bluetooth_adapter.hpp"
 #include "../btdrv_mitm_flags.hpp"
 #include "../../controllers/controller_management.hpp"
+#include "../../btm_mitm/btm_device_cache.hpp"
+#include "../../mcmitm_config.hpp"
 #include <mutex>
 #include <cstring>
 
@@ -35,6 +38,69 @@ namespace ams::bluetooth::core {
         os::Event g_enable_event(os::EventClearMode_ManualClear);
         os::Event g_data_read_event(os::EventClearMode_AutoClear);
 
+        // Inquiry results repeated within this window aren't forwarded to btm again
+        constexpr auto inquiry_repeat_window = TimeSpan::FromSeconds(3);
+        constexpr size_t MaxRecentInquiryResults = 16;
+
+        struct RecentInquiryResult {
+            bluetooth::Address address;
+            os::Tick tick;
+        };
+
+        RecentInquiryResult g_recent_inquiry_results[MaxRecentInquiryResults];
+        size_t g_next_inquiry_result;
+
+        // Only read by the thread handling core events
+        mitm::CachedConfig g_inquiry_config;
+
+        bool IsRepeatedInquiryResult(const bluetooth::Address *address) {
+            auto now = os::GetSystemTick();
+
+            for (auto &entry : g_recent_inquiry_results) {
+                if ((entry.tick.GetInt64Value() != 0) && (std::memcmp(&entry.address, address, sizeof(bluetooth::Address)) == 0)) {
+                    if ((now - entry.tick) < os::ConvertToTick(inquiry_repeat_window))
+                        return true;
+
+                    entry.tick = now;
+                    return false;
+                }
+            }
+
+            // Replace the oldest entry
+            auto entry = &g_recent_inquiry_results[g_next_inquiry_result];
+            entry->address = *address;
+            entry->tick = now;
+            g_next_inquiry_result = (g_next_inquiry_result + 1) % MaxRecentInquiryResults;
+
+            return false;
+        }
+
+        // Crowded environments produce a flood of inquiry results from phones, headphones etc. Dropping them here saves a
+        // blocking round trip with btm for each one
+        bool IsFilteredInquiryResult(void) {
+            const bluetooth::Address *address;
+            const bluetooth::DeviceClass *cod;
+            if (hos::GetVersion() < hos::Version_12_0_0) {
+                if (g_current_event_type != BtdrvEventTypeOld_InquiryDevice)
+                    return false;
+
+                address = &g_event_info.inquiry_device.v1.addr;
+                cod = &g_event_info.inquiry_device.v1.class_of_device;
+            }
+            else {
+                if (g_current_event_type != BtdrvEventType_InquiryDevice)
+                    return false;
+
+                address = &g_event_info.inquiry_device.v12.addr;
+                cod = &g_event_info.inquiry_device.v12.class_of_device;
+            }
+
+            if (!g_inquiry_config.Get()->bluetooth.filter_inquiry_results)
+                return false;
+
+            return !controller::IsPeripheralDeviceClass(cod) || IsRepeatedInquiryResult(address);
+        }
+
     }
 
     bool IsInitialized() {
@@ -147,12 +213,8 @@ namespace ams::bluetooth::core {
 
         // Reverse host address as pin code for wii devices
         if (std::strncmp(g_event_info.pairing_pin_code_request.name, controller::wii_controller_prefix, std::strlen(controller::wii_controller_prefix)) == 0) {
-            // Fetch host adapter address
-            bluetooth::Address host_address;
-            R_ABORT_UNLESS(btdrvLegacyGetAdapterProperty(BtdrvBluetoothPropertyType_Address, &host_address, sizeof(bluetooth::Address)));
-            // Reverse host address
-            *reinterpret_cast<uint64_t *>(&pin) = util::SwapBytes(*reinterpret_cast<uint64_t *>(&host_address)) >> 16;
-            pin_length = sizeof(bluetooth::Address);
+            pin = {};
+            pin_length = bluetooth::adapter::GetWiiPinCode(pin.code);
         }
 
         R_ABORT_UNLESS(btdrvLegacyRespondToPinRequest(g_event_info.pairing_pin_code_request.addr, false, &pin, pin_length));
@@ -164,24 +226,46 @@ namespace ams::bluetooth::core {
 
         // Reverse host address as pin code for wii devices
         if (std::strncmp(g_event_info.pairing_pin_code_request.name, controller::wii_controller_prefix, std::strlen(controller::wii_controller_prefix)) == 0) {
-            // Fetch host adapter address
-            BtdrvAdapterProperty property;
-            R_ABORT_UNLESS(btdrvGetAdapterProperty(BtdrvAdapterPropertyType_Address, &property));
-            // Reverse host address
-            bluetooth::Address host_address = *reinterpret_cast<bluetooth::Address *>(property.data);
-            *reinterpret_cast<uint64_t *>(&pin.code) = util::SwapBytes(*reinterpret_cast<uint64_t *>(&host_address)) >> 16;
-            pin.length = sizeof(bluetooth::Address);
+            pin = {};
+            pin.length = bluetooth::adapter::GetWiiPinCode(pin.code);
         }
 
         R_ABORT_UNLESS(btdrvRespondToPinRequest(g_event_info.pairing_pin_code_request.addr, &pin));
     }
 
+    // Discovery results and pairing prompts are the only core events that can't change the device condition or device info reported by btm
+    inline bool AffectsDeviceCache(bluetooth::EventType type) {
+        if (hos::GetVersion() < hos::Version_12_0_0) {
+            return (type != BtdrvEventTypeOld_InquiryDevice)
+                && (type != BtdrvEventTypeOld_DiscoveryStateChanged)
+                && (type != BtdrvEventTypeOld_PairingPinCodeRequest)
+                && (type != BtdrvEventTypeOld_SspRequest);
+        }
+
+        return (type != BtdrvEventType_InquiryDevice)
+            && (type != BtdrvEventType_DiscoveryStateChanged)
+            && (type != BtdrvEventType_PairingPinCodeRequest)
+            && (type != BtdrvEventType_SspRequest);
+    }
+
     void HandleEvent(void) {
         {
             std::scoped_lock lk(g_event_info_lock);
             R_ABORT_UNLESS(btdrvGetEventInfo(&g_event_info, sizeof(bluetooth::EventInfo), &g_current_event_type));
         }
 
+        if (AffectsDeviceCache(g_current_event_type)) {
+            mitm::btm::InvalidateDeviceCache();
+        }
+
+        // A device pairing again may not be the one previously seen at this address
+        if (g_current_event_type == (hos::GetVersion() < hos::Version_12_0_0 ? BtdrvEventTypeOld_PairingPinCodeRequest : BtdrvEventType_PairingPinCodeRequest)) {
+            controller::InvalidateIdentity(&g_event_info.pairing_pin_code_request.addr);
+        }
+        else if (g_current_event_type == (hos::GetVersion() < hos::Version_12_0_0 ? BtdrvEventTypeOld_SspRequest : BtdrvEventType_SspRequest)) {
+            controller::InvalidateIdentity(hos::GetVersion() < hos::Version_12_0_0 ? &g_event_info.ssp_request.v1.addr : &g_event_info.ssp_request.v12.addr);
+        }
+
         if (!g_redirect_core_events) {
             if ((hos::GetVersion() < hos::Version_12_0_0) && (g_current_event_type == BtdrvEventTypeOld_PairingPinCodeRequest)) {
                 HandlePinCodeRequestEventV1(&g_event_info);
@@ -189,7 +273,7 @@ namespace ams::bluetooth::core {
             else if ((hos::GetVersion() >= hos::Version_12_0_0) && (g_current_event_type == BtdrvEventType_PairingPinCodeRequest)) {
                 HandlePinCodeRequestEventV12(&g_event_info);
             }
-            else {
+            else if (!IsFilteredInquiryResult()) {
                 g_system_event_fwd.Signal();
                 g_data_read_event.Wait();
             }
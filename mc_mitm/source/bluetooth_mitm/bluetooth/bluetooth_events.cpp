@@ -18,6 +18,8 @@
 #include "bluetooth_core.hpp"
 #include "bluetooth_hid.hpp"
 #include "bluetooth_ble.hpp"
+#include "../../controllers/controller_identity_cache.hpp"
+#include "../../mcmitm_utils.hpp"
 
 namespace ams::bluetooth::events {
 
@@ -30,6 +32,14 @@ namespace ams::bluetooth::events {
         os::WaitableHolderType 	g_holder_bt_core;
         os::WaitableHolderType 	g_holder_bt_hid;
         os::WaitableHolderType 	g_holder_bt_ble;
+        os::WaitableHolderType 	g_holder_bt_hid_fake;
+        os::WaitableHolderType 	g_holder_identity_cache;
+
+        // Connection events faked for virtual controllers are delivered from here, so they never race the real ones
+        constexpr uintptr_t FakeHidEventUserData = BtdrvEventType_BluetoothBle + 1;
+
+        // The identity cache is written back from here rather than from a thread of its own, saving its stack
+        constexpr uintptr_t IdentityCacheEventUserData = BtdrvEventType_BluetoothBle + 2;
 
         void EventHandlerThreadFunc(void *arg) {
             os::InitializeWaitableManager(&g_manager);
@@ -44,6 +54,14 @@ namespace ams::bluetooth::events {
             os::SetWaitableHolderUserData(&g_holder_bt_hid, BtdrvEventType_BluetoothHid);
             os::LinkWaitableHolder(&g_manager, &g_holder_bt_hid);
 
+            os::InitializeWaitableHolder(&g_holder_bt_hid_fake, hid::GetFakeEvent()->GetBase());
+            os::SetWaitableHolderUserData(&g_holder_bt_hid_fake, FakeHidEventUserData);
+            os::LinkWaitableHolder(&g_manager, &g_holder_bt_hid_fake);
+
+            os::InitializeWaitableHolder(&g_holder_identity_cache, controller::GetWriteBackEvent()->GetBase());
+            os::SetWaitableHolderUserData(&g_holder_identity_cache, IdentityCacheEventUserData);
+            os::LinkWaitableHolder(&g_manager, &g_holder_identity_cache);
+
             if (hos::GetVersion() >= hos::Version_5_0_0) {
                 ams::bluetooth::ble::WaitInitialized();
                 os::InitializeWaitableHolder(&g_holder_bt_ble, ble::GetSystemEvent()->GetBase());
@@ -66,6 +84,13 @@ namespace ams::bluetooth::events {
                         ble::GetSystemEvent()->Clear();
                         ble::HandleEvent();
                         break;
+                    case FakeHidEventUserData:
+                        hid::HandleFakeEvent();
+                        break;
+                    case IdentityCacheEventUserData:
+                        controller::GetWriteBackEvent()->Clear();
+                        controller::WriteBackIdentityCache();
+                        break;
                     default:
                         break;	
                 }
@@ -75,6 +100,7 @@ namespace ams::bluetooth::events {
     }
 
     Result Initialize(void) {
+        mitm::utils::PaintThreadStack("bt_events", g_event_handler_thread_stack, sizeof(g_event_handler_thread_stack));
         R_TRY(os::CreateThread(&g_event_handler_thread, 
             EventHandlerThreadFunc, 
             nullptr, 
@@ -16,6 +16,8 @@
 #include "bluetooth_hid.hpp"
 #include "../btdrv_mitm_flags.hpp"
 #include "../../controllers/controller_management.hpp"
+#include "../../controllers/virtual_controller.hpp"
+#include "../../btm_mitm/btm_device_cache.hpp"
 #include <mutex>
 #include <cstring>
 
@@ -23,6 +25,15 @@ namespace ams::bluetooth::hid {
 
     namespace {
 
+        // Enough for every virtual controller to connect and disconnect before the events thread catches up
+        constexpr size_t max_fake_connection_events = 2 * controller::MaxVirtualControllers;
+
+        struct FakeConnectionEvent {
+            bluetooth::Address address;
+            bool connected;
+        };
+
+        os::Mutex g_event_dispatch_lock(false);
         os::Mutex g_event_info_lock(false);
         bluetooth::HidEventInfo g_event_info;
         bluetooth::HidEventType g_current_event_type;
@@ -34,6 +45,36 @@ namespace ams::bluetooth::hid {
         os::Event g_init_event(os::EventClearMode_ManualClear);
         os::Event g_data_read_event(os::EventClearMode_AutoClear);
 
+        os::Mutex g_fake_event_lock(false);
+        os::Event g_fake_event(os::EventClearMode_ManualClear);
+        FakeConnectionEvent g_fake_events[max_fake_connection_events];
+        size_t g_fake_event_head;
+        size_t g_fake_event_count;
+
+        bool PopFakeConnectionEvent(FakeConnectionEvent *event) {
+            std::scoped_lock lk(g_fake_event_lock);
+
+            if (g_fake_event_count == 0) {
+                g_fake_event.Clear();
+                return false;
+            }
+
+            *event = g_fake_events[g_fake_event_head];
+            g_fake_event_head = (g_fake_event_head + 1) % max_fake_connection_events;
+            --g_fake_event_count;
+
+            return true;
+        }
+
+        void DispatchEvent(void) {
+            g_system_event_fwd.Signal();
+            g_data_read_event.Wait();
+
+            if (g_system_event_user_fwd.GetBase()->state) {
+                g_system_event_user_fwd.Signal();
+            }
+        }
+
     }
 
     bool IsInitialized() {
@@ -67,6 +108,25 @@ namespace ams::bluetooth::hid {
         g_system_event_fwd.Signal();
     }
 
+    os::Event *GetFakeEvent(void) {
+        return &g_fake_event;
+    }
+
+    Result QueueFakeConnectionEvent(const bluetooth::Address *address, bool connected) {
+        std::scoped_lock lk(g_fake_event_lock);
+
+        if (g_fake_event_count == max_fake_connection_events)
+            return -1;
+
+        g_fake_events[(g_fake_event_head + g_fake_event_count) % max_fake_connection_events] = {*address, connected};
+        ++g_fake_event_count;
+
+        // The events thread delivers it, so it goes through the same handshake with hid as a real event
+        g_fake_event.Signal();
+
+        return ams::ResultSuccess();
+    }
+
     Result GetEventInfo(bluetooth::HidEventType *type, void *buffer, size_t size) {
         std::scoped_lock lk(g_event_info_lock);
 
@@ -105,11 +165,16 @@ namespace ams::bluetooth::hid {
     }
 
     void HandleEvent(void) {
+        std::scoped_lock lk(g_event_dispatch_lock);
+
         {
             std::scoped_lock lk(g_event_info_lock);
             R_ABORT_UNLESS(btdrvGetHidEventInfo(&g_event_info, sizeof(bluetooth::HidEventInfo), &g_current_event_type));
         }
 
+        // Connection changes as well as tsi and burst mode results all alter the device condition reported by btm
+        mitm::btm::InvalidateDeviceCache();
+
         switch (g_current_event_type) {
             case BtdrvHidEventType_Connection:
                 hos::GetVersion() < hos::Version_12_0_0 ? HandleConnectionStateEventV1(&g_event_info) : HandleConnectionStateEventV12(&g_event_info);
@@ -118,11 +183,31 @@ namespace ams::bluetooth::hid {
                 break;
         }
 
-        g_system_event_fwd.Signal();
-        g_data_read_event.Wait();
+        DispatchEvent();
+    }
+
+    void HandleFakeEvent(void) {
+        FakeConnectionEvent event;
+        while (PopFakeConnectionEvent(&event)) {
+            std::scoped_lock lk(g_event_dispatch_lock);
+
+            {
+                std::scoped_lock lk(g_event_info_lock);
+
+                g_current_event_type = BtdrvHidEventType_Connection;
+                std::memset(&g_event_info, 0, sizeof(g_event_info));
+                if (hos::GetVersion() < hos::Version_12_0_0) {
+                    g_event_info.connection.v1.addr = event.address;
+                    g_event_info.connection.v1.status = event.connected ? BtdrvHidConnectionStatusOld_Opened : BtdrvHidConnectionStatusOld_Closed;
+                } else {
+                    g_event_info.connection.v12.addr = event.address;
+                    g_event_info.connection.v12.status = event.connected ? BtdrvHidConnectionStatus_Opened : BtdrvHidConnectionStatus_Closed;
+                }
+            }
+
+            mitm::btm::InvalidateDeviceCache();
 
-        if (g_system_event_user_fwd.GetBase()->state) {
-            g_system_event_user_fwd.Signal();
+            DispatchEvent();
         }
     }
 
@@ -29,7 +29,11 @@ namespace ams::bluetooth::hid {
     os::SystemEvent *GetUserForwardEvent(void);
 
     void SignalFakeEvent(bluetooth::HidEventType type, const void *data, size_t size);
+    os::Event *GetFakeEvent(void);
+
+    Result QueueFakeConnectionEvent(const bluetooth::Address *address, bool connected);
     Result GetEventInfo(bluetooth::HidEventType *type, void *buffer, size_t size);
     void HandleEvent(void);
+    void HandleFakeEvent(void);
 
 }
@@ -14,11 +14,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "bluetooth_hid_report.hpp"
-#include "bluetooth_circular_buffer.hpp"
+#include "bluetooth_hid_report_dispatch.hpp"
 #include "../btdrv_shim.h"
 #include "../btdrv_mitm_flags.hpp"
 #include "../../mcmitm_utils.hpp"
 #include "../../controllers/controller_management.hpp"
+#include "../../controllers/virtual_controller.hpp"
 #include <mutex>
 #include <cstring>
 
@@ -27,6 +28,10 @@ namespace ams::bluetooth::hid::report {
     namespace {
 
         constexpr auto bluetooth_sharedmem_size = 0x3000;
+        constexpr auto read_control_sharedmem_size = 0x1000;
+
+        // Upper bound on how long a redirect client can hold up report handling
+        constexpr auto report_read_timeout = TimeSpan::FromMilliSeconds(10);
 
         os::ThreadType g_event_handler_thread;
         alignas(os::ThreadStackAlignment) uint8_t g_event_handler_thread_stack[0x1000];
@@ -41,23 +46,61 @@ namespace ams::bluetooth::hid::report {
         os::SystemEvent g_system_event_user_fwd(os::EventClearMode_AutoClear, true);
 
         os::Event g_init_event(os::EventClearMode_ManualClear);
-        os::Event g_report_read_event(os::EventClearMode_AutoClear);
+        os::SystemEvent g_report_read_event(os::EventClearMode_AutoClear, true);
+
+        os::WaitableManagerType g_manager;
+        os::WaitableHolderType g_holder_report;
+        os::WaitableHolderType g_holder_virtual_input;
 
         SharedMemory g_real_bt_shmem;
         SharedMemory g_fake_bt_shmem;
+        SharedMemory g_read_control_shmem;
 
         bluetooth::CircularBuffer *g_real_buffer;
         bluetooth::CircularBuffer *g_fake_buffer;
 
-        bluetooth::HidReportEventInfo g_fake_report_event_info;
+        HidReportReadControl *g_read_control;
 
         Service *g_forward_service;
         os::ThreadId g_main_thread_id;
 
+        void WaitReportRead(void) {
+            if (!g_shared_hid_report_read || !g_read_control) {
+                g_system_event_user_fwd.Signal();
+                g_report_read_event.Wait();
+                return;
+            }
+
+            // Reports are processed whether or not the client kept up, and a stalled client is skipped until it catches up
+            HandOverReportEvents(g_read_control, &g_system_event_user_fwd, &g_report_read_event, report_read_timeout);
+        }
+
         void EventThreadFunc(void *arg) {
+            TimeSpan timeout;
+            bool paced = false;
+
+            // Frames written by virtual controller clients wake us too, so their rings never need polling
+            os::InitializeWaitableManager(&g_manager);
+            os::InitializeWaitableHolder(&g_holder_report, g_system_event.GetBase());
+            os::LinkWaitableHolder(&g_manager, &g_holder_report);
+            os::InitializeWaitableHolder(&g_holder_virtual_input, controller::GetVirtualInputEvent()->GetBase());
+            os::LinkWaitableHolder(&g_manager, &g_holder_virtual_input);
+
             while (true) {
-                g_system_event.Wait();
-                HandleEvent();
+                // Wake up in time to service any controllers pacing their reports
+                auto signalled_holder = paced ? os::TimedWaitAny(&g_manager, timeout) : os::WaitAny(&g_manager);
+                if (signalled_holder == &g_holder_report) {
+                    g_system_event.Clear();
+                    HandleEvent();
+                }
+                else if (signalled_holder == &g_holder_virtual_input) {
+                    // Virtual controllers drain their input rings when serviced
+                    controller::GetVirtualInputEvent()->Clear();
+                    controller::RequestPacingService();
+                }
+
+                controller::ApplyConfigUpdates();
+                paced = controller::ServicePacedControllers(&timeout);
             }
         }
 
@@ -72,6 +115,10 @@ namespace ams::bluetooth::hid::report {
     }
 
     void SignalReportRead(void) {
+        // Acknowledge through the shared page too, so the ipc command remains usable in shared mode
+        if (g_read_control)
+            g_read_control->consumed.store(g_read_control->produced.load(std::memory_order_acquire), std::memory_order_release);
+
         g_report_read_event.Signal();
     }
 
@@ -86,6 +133,21 @@ namespace ams::bluetooth::hid::report {
         return &g_fake_bt_shmem;
     }
 
+    SharedMemory *GetReadControlSharedMemory(void) {
+        if (!g_read_control)
+            return nullptr;
+
+        return &g_read_control_shmem;
+    }
+
+    os::SystemEvent *GetReportReadEvent(void) {
+        return &g_report_read_event;
+    }
+
+    bluetooth::CircularBuffer *GetFakeBuffer(void) {
+        return g_fake_buffer;
+    }
+
     os::SystemEvent *GetSystemEvent(void) {
         return &g_system_event;
     }
@@ -101,6 +163,7 @@ namespace ams::bluetooth::hid::report {
     Result Initialize(Handle event_handle, Service *forward_service, os::ThreadId main_thread_id) {
         g_system_event.AttachReadableHandle(event_handle, false, os::EventClearMode_AutoClear);
 
+        mitm::utils::PaintThreadStack("hid_report", g_event_handler_thread_stack, sizeof(g_event_handler_thread_stack));
         R_TRY(os::CreateThread(&g_event_handler_thread, 
             EventThreadFunc, 
             nullptr, 
@@ -140,29 +203,17 @@ namespace ams::bluetooth::hid::report {
         g_fake_buffer->type = bluetooth::CircularBufferType_HidReport;
         g_fake_buffer->_unk3 = 1;
 
+        R_TRY(shmemCreate(&g_read_control_shmem, read_control_sharedmem_size, Perm_Rw, Perm_Rw));
+        R_TRY(shmemMap(&g_read_control_shmem));
+        g_read_control = reinterpret_cast<HidReportReadControl *>(shmemGetAddr(&g_read_control_shmem));
+
         return ams::ResultSuccess();
     }
 
-    Result WriteHidReportBuffer(const bluetooth::Address *address, const bluetooth::HidReport *report) {
-        if (hos::GetVersion() < hos::Version_9_0_0) {
-            // Todo: check this may still be necessary
-            //g_fake_report_event_info.data_report.v7.size = g_fake_report_event_info.data_report.v7.report.size + 0x11;
-            g_fake_report_event_info.data_report.v7.addr = *address;
-            std::memcpy(&g_fake_report_event_info.data_report.v7.report, report, report->size + sizeof(report->size));
-        }
-        else {
-            g_fake_report_event_info.data_report.v9.addr = *address;
-            std::memcpy(&g_fake_report_event_info.data_report.v9.report, report, report->size + sizeof(report->size));
-        }
-
-        if (hos::GetVersion() >= hos::Version_12_0_0)
-            g_fake_buffer->Write(BtdrvHidEventType_Data, &g_fake_report_event_info, report->size + 0x11);
-        else
-            g_fake_buffer->Write(BtdrvHidEventTypeOld_Data, &g_fake_report_event_info, report->size + 0x11);
-
-        g_system_event_fwd.Signal();
-
-        return ams::ResultSuccess();
+    Result WriteHidReportBuffer(const bluetooth::Address *address, const bluetooth::HidReport *report, u64 *out_pending) {
+        return WriteHidReportBuffer(address, report->size, [report](bluetooth::HidReport *dst) {
+            std::memcpy(dst, report, report->size + sizeof(report->size));
+        }, out_pending);
     }
 
     Result SendHidReport(const bluetooth::Address *address, const bluetooth::HidReport *report) {
@@ -212,7 +263,7 @@ namespace ams::bluetooth::hid::report {
                     if (!device)
                         return;
 
-                    device->HandleIncomingReport(reinterpret_cast<bluetooth::HidReport *>(&g_event_info.data_report.v1.report));
+                    DispatchIncomingReport(device, reinterpret_cast<bluetooth::HidReport *>(&g_event_info.data_report.v1.report));
                 }
                 break;
             default:
@@ -221,71 +272,13 @@ namespace ams::bluetooth::hid::report {
         }
     }
 
-    inline void HandleHidReportEventV7(void) {
-        while (true) {
-            auto real_packet = g_real_buffer->Read();
-            if (!real_packet)
-                break;
-
-            g_real_buffer->Free();
-
-            switch (real_packet->header.type) {
-                case 0xff:
-                    continue;
-                case BtdrvHidEventTypeOld_Data:
-                    {
-                        auto device = controller::LocateHandler(hos::GetVersion() < hos::Version_9_0_0 ? &real_packet->data.data_report.v7.addr : &real_packet->data.data_report.v9.addr);
-                        if (!device)
-                            continue;
-
-                        auto report = hos::GetVersion() < hos::Version_9_0_0 ? reinterpret_cast<bluetooth::HidReport *>(&real_packet->data.data_report.v7.report) : &real_packet->data.data_report.v9.report;
-                        device->HandleIncomingReport(report);
-                    }
-                    break;
-                default:
-                    g_fake_buffer->Write(real_packet->header.type, &real_packet->data, real_packet->header.size);
-                    break;
-            }
-        } 
-    }
-
-    inline void HandleHidReportEventV12(void) {
-        while (true) {
-            auto real_packet = g_real_buffer->Read();
-            if (!real_packet)
-                break;
-
-            g_real_buffer->Free();
-
-            switch (real_packet->header.type) {
-                case 0xff:
-                    continue;
-                case BtdrvHidEventType_Data:
-                    {
-                        auto device = controller::LocateHandler(&real_packet->data.data_report.v9.addr);
-                        if (!device)
-                            continue;
-
-                        device->HandleIncomingReport(&real_packet->data.data_report.v9.report);
-                    }
-                    break;
-                default:
-                    g_fake_buffer->Write(real_packet->header.type, &real_packet->data, real_packet->header.size);
-                    break;
-            }
-        } 
-    }
-
     void HandleEvent(void) {
         if (g_redirect_hid_report_events) {
-            g_system_event_user_fwd.Signal();
-            g_report_read_event.Wait();
+            WaitReportRead();
         }
 
-        if (hos::GetVersion() >= hos::Version_12_0_0)
-            HandleHidReportEventV12();
-        else if (hos::GetVersion() >= hos::Version_7_0_0)
-            HandleHidReportEventV7();
+        if (hos::GetVersion() >= hos::Version_7_0_0)
+            ProcessReportBuffer(g_real_buffer, g_fake_buffer, controller::LocateHandler);
         else
             HandleHidReportEventV1();
     }
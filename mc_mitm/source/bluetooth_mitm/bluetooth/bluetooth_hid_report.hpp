@@ -17,15 +17,27 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "bluetooth_types.hpp"
+#include "bluetooth_circular_buffer.hpp"
+#include <atomic>
+#include <cstring>
 
 namespace ams::bluetooth::hid::report {
 
+    // Shared page allowing redirect clients to acknowledge report events without an ipc call
+    struct HidReportReadControl {
+        alignas(64) std::atomic<u32> produced;  // Incremented each time report events are handed over to the client
+        alignas(64) std::atomic<u32> consumed;  // Set to the value of produced by the client once it has finished reading
+    };
+
     bool IsInitialized(void);
     void WaitInitialized(void);
     void SignalReportRead(void);
 
     SharedMemory *GetRealSharedMemory(void);
     SharedMemory *GetFakeSharedMemory(void);
+    SharedMemory *GetReadControlSharedMemory(void);
+    os::SystemEvent *GetReportReadEvent(void);
+    bluetooth::CircularBuffer *GetFakeBuffer(void);
 
     os::SystemEvent *GetSystemEvent(void);
     os::SystemEvent *GetForwardEvent(void);
@@ -37,7 +49,39 @@ namespace ams::bluetooth::hid::report {
     Result MapRemoteSharedMemory(Handle handle);
     Result InitializeReportBuffer(void);
 
-    Result WriteHidReportBuffer(const bluetooth::Address *address, const bluetooth::HidReport *report);
+    Result WriteHidReportBuffer(const bluetooth::Address *address, const bluetooth::HidReport *report, u64 *out_pending = nullptr);
+
+    // Write a data report straight into the fake report buffer. The populate callback receives the destination report and is responsible for filling in its size and data.
+    // Fails if the buffer is full, in which case the report is dropped
+    template <typename F>
+    Result WriteHidReportBuffer(const bluetooth::Address *address, u16 report_size, F populate, u64 *out_pending = nullptr) {
+        auto type = hos::GetVersion() >= hos::Version_12_0_0 ? BtdrvHidEventType_Data : BtdrvHidEventTypeOld_Data;
+
+        auto rc = GetFakeBuffer()->Write(type, report_size + 0x11, [&](bluetooth::HidReportEventInfo *event_info) {
+            bluetooth::HidReport *dst;
+            if (hos::GetVersion() < hos::Version_9_0_0) {
+                dst = reinterpret_cast<bluetooth::HidReport *>(&event_info->data_report.v7.report);
+                std::memset(event_info, 0, reinterpret_cast<uintptr_t>(dst) - reinterpret_cast<uintptr_t>(event_info));
+                event_info->data_report.v7.addr = *address;
+            }
+            else {
+                dst = &event_info->data_report.v9.report;
+                std::memset(event_info, 0, reinterpret_cast<uintptr_t>(dst) - reinterpret_cast<uintptr_t>(event_info));
+                event_info->data_report.v9.addr = *address;
+            }
+
+            populate(dst);
+        }, out_pending);
+
+        GetForwardEvent()->Signal();
+
+        // Buffer is full and the report was dropped
+        if (rc != 0)
+            return -1;
+
+        return ams::ResultSuccess();
+    }
+
     Result SendHidReport(const bluetooth::Address *address, const bluetooth::HidReport *report);
 
     Result GetEventInfo(bluetooth::HidEventType *type, void *buffer, size_t size);
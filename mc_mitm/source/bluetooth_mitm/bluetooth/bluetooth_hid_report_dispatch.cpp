@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bluetooth_hid_report_dispatch.hpp"
+#include "../../controllers/load_governor.hpp"
+
+namespace ams::bluetooth::hid::report {
+
+    void DispatchIncomingReport(controller::SwitchController *device, const bluetooth::HidReport *report) {
+        auto stats = device->GetStats();
+        auto start = os::GetSystemTick();
+        stats->RecordInputReport(report->data[0], start);
+
+        device->HandleIncomingReport(report);
+
+        auto end = os::GetSystemTick();
+        stats->RecordTranslationTime(end - start);
+        controller::RecordTranslationWork(start, end);
+    }
+
+    void ProcessReportBuffer(bluetooth::CircularBuffer *real_buffer, bluetooth::CircularBuffer *fake_buffer, ControllerLocator locate) {
+        auto data_type = hos::GetVersion() >= hos::Version_12_0_0 ? BtdrvHidEventType_Data : BtdrvHidEventTypeOld_Data;
+
+        while (true) {
+            auto real_packet = real_buffer->Read();
+            if (!real_packet)
+                break;
+
+            real_buffer->Free();
+
+            if (real_packet->header.type == 0xff)
+                continue;
+
+            if (real_packet->header.type == data_type) {
+                // The report layout only changed in 9.0.0
+                auto address = hos::GetVersion() < hos::Version_9_0_0 ? &real_packet->data.data_report.v7.addr : &real_packet->data.data_report.v9.addr;
+                auto device = locate(address);
+                if (!device)
+                    continue;
+
+                auto report = hos::GetVersion() < hos::Version_9_0_0 ? reinterpret_cast<bluetooth::HidReport *>(&real_packet->data.data_report.v7.report) : &real_packet->data.data_report.v9.report;
+                DispatchIncomingReport(device, report);
+            }
+            else {
+                fake_buffer->Write(real_packet->header.type, &real_packet->data, real_packet->header.size);
+            }
+        }
+    }
+
+    bool HandOverReportEvents(HidReportReadControl *control, os::SystemEvent *user_event, os::SystemEvent *read_event, TimeSpan timeout) {
+        auto produced = control->produced.load(std::memory_order_relaxed);
+        if (control->consumed.load(std::memory_order_acquire) != produced)
+            return false;
+
+        auto sequence = produced + 1;
+        control->produced.store(sequence, std::memory_order_release);
+        user_event->Signal();
+
+        // The client signals the read event after updating consumed. Give up once the deadline passes rather than stalling every controller
+        auto deadline = os::GetSystemTick() + os::ConvertToTick(timeout);
+        while (control->consumed.load(std::memory_order_acquire) != sequence) {
+            auto now = os::GetSystemTick();
+            if ((now >= deadline) || !read_event->TimedWait(os::ConvertToTimeSpan(deadline - now)))
+                return false;
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include "bluetooth_types.hpp"
+#include "bluetooth_circular_buffer.hpp"
+#include "bluetooth_hid_report.hpp"
+#include "../../controllers/switch_controller.hpp"
+
+namespace ams::bluetooth::hid::report {
+
+    // Maps the address of a data report to the controller translating it, or nullptr if it isn't one of ours
+    using ControllerLocator = controller::SwitchController *(*)(const bluetooth::Address *address);
+
+    void DispatchIncomingReport(controller::SwitchController *device, const bluetooth::HidReport *report);
+
+    // Drains every packet btdrv has written to the real buffer, translating data reports and passing any other events on to the fake buffer untouched
+    void ProcessReportBuffer(bluetooth::CircularBuffer *real_buffer, bluetooth::CircularBuffer *fake_buffer, ControllerLocator locate);
+
+    // Hands report events to a redirect client acknowledging through the shared read control page, and waits up to timeout for it to finish reading.
+    // A client still behind on an earlier batch isn't handed another, so a stalled client holds up report handling once rather than on every batch.
+    // Returns whether the client read the events in time
+    bool HandOverReportEvents(HidReportReadControl *control, os::SystemEvent *user_event, os::SystemEvent *read_event, TimeSpan timeout);
+
+}
@@ -69,6 +69,7 @@ namespace ams::mitm::bluetooth {
     }
 
     Result Launch(void) {
+        utils::PaintThreadStack("btdrv_mitm", g_btdrv_mitm_thread_stack, sizeof(g_btdrv_mitm_thread_stack));
         R_TRY(os::CreateThread(&g_btdrv_mitm_thread,
             BtdrvMitmThreadFunction,
             nullptr,
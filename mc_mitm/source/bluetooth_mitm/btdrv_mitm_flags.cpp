@@ -21,5 +21,6 @@ namespace ams {
     std::atomic<bool> g_redirect_hid_events        = false;
     std::atomic<bool> g_redirect_hid_report_events = false;
     std::atomic<bool> g_redirect_ble_events        = false;
+    std::atomic<bool> g_shared_hid_report_read     = false;
 
 }
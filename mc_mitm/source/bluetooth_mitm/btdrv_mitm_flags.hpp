@@ -22,5 +22,6 @@ namespace ams {
     extern std::atomic<bool> g_redirect_hid_events;
     extern std::atomic<bool> g_redirect_hid_report_events;
     extern std::atomic<bool> g_redirect_ble_events;
+    extern std::atomic<bool> g_shared_hid_report_read;
 
 }
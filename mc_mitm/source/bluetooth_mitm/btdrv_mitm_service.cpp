@@ -20,12 +20,24 @@
 #include "bluetooth/bluetooth_hid.hpp"
 #include "bluetooth/bluetooth_ble.hpp"
 #include "../mcmitm_initialization.hpp"
+#include "../mcmitm_utils.hpp"
 #include "../controllers/controller_management.hpp"
+#include "../controllers/virtual_controller.hpp"
+#include "../btm_mitm/btm_device_cache.hpp"
 #include <switch.h>
 #include <cstring>
+#include <algorithm>
 
 namespace ams::mitm::bluetooth {
 
+    BtdrvMitmService::~BtdrvMitmService(void) {
+        // Tear down any virtual controllers left behind by a client that exited or crashed
+        for (size_t i = 0; i < m_num_virtual_controllers; ++i) {
+            if (R_SUCCEEDED(controller::RemoveVirtualHandler(&m_virtual_controllers[i])))
+                ams::bluetooth::hid::QueueFakeConnectionEvent(&m_virtual_controllers[i], false);
+        }
+    }
+
     Result BtdrvMitmService::InitializeBluetooth(sf::OutCopyHandle out_handle) {
         if (!ams::bluetooth::core::IsInitialized()) {
             // Forward to the real function to obtain the system event handle
@@ -53,6 +65,7 @@ namespace ams::mitm::bluetooth {
     Result BtdrvMitmService::EnableBluetooth(void) {
         R_TRY(btdrvEnableBluetoothFwd(this->forward_service.get()));
         ams::bluetooth::core::SignalEnabled();
+        ams::mitm::RecordBootPhase(ams::mitm::BootPhase_BluetoothEnabled);
 
         // Wait until mc.mitm module initialisation has completed before returning
         ams::mitm::WaitInitialized();
@@ -98,6 +111,7 @@ namespace ams::mitm::bluetooth {
         if (this->client_info.program_id == ncm::SystemProgramId::Hid) {
             auto device = controller::LocateHandler(&address);
             if (device) {
+                device->GetStats()->RecordOutputReport(report->data[0]);
                 device->HandleOutgoingReport(report);
             }
         }
@@ -117,6 +131,15 @@ namespace ams::mitm::bluetooth {
         return ams::ResultSuccess();
     }
 
+    Result BtdrvMitmService::RemoveBond(ams::bluetooth::Address address) {
+        R_TRY(btdrvRemoveBondFwd(this->forward_service.get(), &address));
+
+        // The unpaired device must no longer be listed in the device info reported by btm
+        mitm::btm::InvalidateDeviceCache();
+
+        return ams::ResultSuccess();
+    }
+
     Result BtdrvMitmService::SetTsi(ams::bluetooth::Address address, u8 tsi) {
         auto device = controller::LocateHandler(&address);
         if (!device || device->SupportsSetTsiCommand())
@@ -152,6 +175,11 @@ namespace ams::mitm::bluetooth {
             ams::bluetooth::core::SignalFakeEvent(BtdrvEventType_Tsi, &event_data, sizeof(event_data));
         }
 
+        controller::SetTsi(&address, tsi);
+
+        // The faked event never reaches our event handlers, so the condition btm reports must be refetched here
+        mitm::btm::InvalidateDeviceCache();
+
         return ams::ResultSuccess();
     }
 
@@ -260,6 +288,10 @@ namespace ams::mitm::bluetooth {
 
     void BtdrvMitmService::RedirectHidReportEvents(bool redirect) {
         g_redirect_hid_report_events = redirect;
+
+        // Clients must opt in to shared memory acknowledgement each time they start redirecting
+        if (!redirect)
+            g_shared_hid_report_read = false;
     }
 
     void BtdrvMitmService::RedirectBleEvents(bool redirect) {
@@ -270,4 +302,101 @@ namespace ams::mitm::bluetooth {
         ams::bluetooth::hid::report::SignalReportRead();
     }
 
+    Result BtdrvMitmService::GetControllerStatistics(sf::Out<u32> out_count, const sf::OutBuffer &out_stats) {
+        auto stats = reinterpret_cast<controller::ControllerStatistics *>(out_stats.GetPointer());
+        out_count.SetValue(controller::GetControllerStatistics(stats, out_stats.GetSize() / sizeof(controller::ControllerStatistics)));
+
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::GetControllerStateFeed(sf::OutCopyHandle out_handle) {
+        auto shmem = controller::GetStateFeedSharedMemory();
+        if (!shmem)
+            return -1;
+
+        out_handle.SetValue(shmem->handle);
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::GetHidReportReadSharedMemory(sf::OutCopyHandle out_handle, sf::OutCopyHandle out_event_handle) {
+        auto shmem = ams::bluetooth::hid::report::GetReadControlSharedMemory();
+        if (!shmem)
+            return -1;
+
+        // Clients signal the event after acknowledging through the shared page
+        out_handle.SetValue(shmem->handle);
+        out_event_handle.SetValue(ams::bluetooth::hid::report::GetReportReadEvent()->GetWritableHandle());
+        g_shared_hid_report_read = true;
+
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::CreateVirtualController(sf::Out<ams::bluetooth::Address> out_address, sf::OutCopyHandle out_handle, sf::OutCopyHandle out_event_handle) {
+        if (!ams::bluetooth::hid::IsInitialized())
+            return -1;
+
+        if (m_num_virtual_controllers >= controller::MaxVirtualControllers)
+            return -1;
+
+        ams::bluetooth::Address address;
+        Handle handle;
+        R_TRY(controller::AttachVirtualHandler(&address, &handle));
+
+        // Announce the new controller to hid as if it had just connected
+        auto rc = ams::bluetooth::hid::QueueFakeConnectionEvent(&address, true);
+        if (R_FAILED(rc)) {
+            controller::RemoveVirtualHandler(&address);
+            return rc;
+        }
+
+        m_virtual_controllers[m_num_virtual_controllers++] = address;
+
+        out_address.SetValue(address);
+        out_handle.SetValue(handle);
+        out_event_handle.SetValue(controller::GetVirtualInputEvent()->GetWritableHandle());
+
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::DestroyVirtualController(ams::bluetooth::Address address) {
+        // Sessions can only destroy the controllers they created
+        auto end = m_virtual_controllers + m_num_virtual_controllers;
+        auto it = std::find_if(m_virtual_controllers, end, [&address](const ams::bluetooth::Address &entry) {
+            return std::memcmp(&entry, &address, sizeof(ams::bluetooth::Address)) == 0;
+        });
+
+        if (it == end)
+            return -1;
+
+        *it = m_virtual_controllers[--m_num_virtual_controllers];
+
+        R_TRY(controller::RemoveVirtualHandler(&address));
+
+        R_TRY(ams::bluetooth::hid::QueueFakeConnectionEvent(&address, false));
+
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::ReloadConfig(void) {
+        // Controllers pick up the new snapshot the next time the report thread wakes
+        return ams::mitm::ReloadConfig();
+    }
+
+    Result BtdrvMitmService::GetBootTimestamps(sf::Out<ams::mitm::BootTimestamps> out_timestamps) {
+        ams::mitm::GetBootTimestamps(out_timestamps.GetPointer());
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::GetThreadStackUsage(sf::Out<u32> out_count, const sf::OutBuffer &out_usage) {
+        auto usage = reinterpret_cast<ams::mitm::utils::ThreadStackUsage *>(out_usage.GetPointer());
+        out_count.SetValue(ams::mitm::utils::GetThreadStackUsage(usage, out_usage.GetSize() / sizeof(ams::mitm::utils::ThreadStackUsage)));
+
+        return ams::ResultSuccess();
+    }
+
+    Result BtdrvMitmService::GetLoadGovernorState(sf::Out<ams::controller::LoadGovernorState> out_state) {
+        controller::GetLoadGovernorState(out_state.GetPointer());
+        return ams::ResultSuccess();
+    }
+
 }
@@ -16,10 +16,14 @@
 #pragma once
 #include <stratosphere.hpp>
 #include "bluetooth/bluetooth_types.hpp"
+#include "../mcmitm_initialization.hpp"
+#include "../controllers/load_governor.hpp"
+#include "../controllers/virtual_controller.hpp"
 
 #define AMS_BTDRV_MITM_INTERFACE_INFO(C, H)                                                                                                                                                                                             \
     AMS_SF_METHOD_INFO(C, H, 1,     Result, InitializeBluetooth,              (sf::OutCopyHandle out_handle),                                                           (out_handle))                                                   \
     AMS_SF_METHOD_INFO(C, H, 2,     Result, EnableBluetooth,                  (void),                                                                                   ())                                                             \
+    AMS_SF_METHOD_INFO(C, H, 11,    Result, RemoveBond,                       (ams::bluetooth::Address address),                                                        (address))                                                      \
     AMS_SF_METHOD_INFO(C, H, 15,    Result, GetEventInfo,                     (sf::Out<ams::bluetooth::EventType> out_type, const sf::OutPointerBuffer &out_buffer),    (out_type, out_buffer))                                         \
     AMS_SF_METHOD_INFO(C, H, 16,    Result, InitializeHid,                    (sf::OutCopyHandle out_handle, u16 version),                                              (out_handle, version))                                          \
     AMS_SF_METHOD_INFO(C, H, 19,    Result, WriteHidData,                     (ams::bluetooth::Address address, const sf::InPointerBuffer &buffer),                     (address, buffer))                                              \
@@ -40,6 +44,15 @@
     AMS_SF_METHOD_INFO(C, H, 65004, void,   RedirectHidReportEvents,          (bool redirect),                                                                          (redirect))                                                     \
     AMS_SF_METHOD_INFO(C, H, 65005, void,   RedirectBleEvents,                (bool redirect),                                                                          (redirect))                                                     \
     AMS_SF_METHOD_INFO(C, H, 65006, void,   SignalHidReportRead,              (void),                                                                                   ())                                                             \
+    AMS_SF_METHOD_INFO(C, H, 65007, Result, GetControllerStatistics,          (sf::Out<u32> out_count, const sf::OutBuffer &out_stats),                                 (out_count, out_stats))                                         \
+    AMS_SF_METHOD_INFO(C, H, 65008, Result, GetControllerStateFeed,           (sf::OutCopyHandle out_handle),                                                           (out_handle))                                                   \
+    AMS_SF_METHOD_INFO(C, H, 65009, Result, GetHidReportReadSharedMemory,     (sf::OutCopyHandle out_handle, sf::OutCopyHandle out_event_handle),                       (out_handle, out_event_handle))                                 \
+    AMS_SF_METHOD_INFO(C, H, 65010, Result, CreateVirtualController,          (sf::Out<ams::bluetooth::Address> out_address, sf::OutCopyHandle out_handle, sf::OutCopyHandle out_event_handle), (out_address, out_handle, out_event_handle)) \
+    AMS_SF_METHOD_INFO(C, H, 65011, Result, DestroyVirtualController,         (ams::bluetooth::Address address),                                                        (address))                                                      \
+    AMS_SF_METHOD_INFO(C, H, 65012, Result, ReloadConfig,                     (void),                                                                                   ())                                                             \
+    AMS_SF_METHOD_INFO(C, H, 65013, Result, GetBootTimestamps,                (sf::Out<ams::mitm::BootTimestamps> out_timestamps),                                      (out_timestamps))                                               \
+    AMS_SF_METHOD_INFO(C, H, 65014, Result, GetThreadStackUsage,              (sf::Out<u32> out_count, const sf::OutBuffer &out_usage),                                 (out_count, out_usage))                                         \
+    AMS_SF_METHOD_INFO(C, H, 65015, Result, GetLoadGovernorState,             (sf::Out<ams::controller::LoadGovernorState> out_state),                                  (out_state))                                                    \
 
 AMS_SF_DEFINE_MITM_INTERFACE(ams::mitm::bluetooth, IBtdrvMitmInterface, AMS_BTDRV_MITM_INTERFACE_INFO)
 
@@ -50,6 +63,9 @@ namespace ams::mitm::bluetooth {
         public:
             using MitmServiceImplBase::MitmServiceImplBase;
 
+            // Virtual controllers don't outlive the session that created them, even if the client exits without destroying them
+            ~BtdrvMitmService(void);
+
         public:
             static bool ShouldMitm(const sm::MitmProcessInfo &client_info) {
                 return true;
@@ -60,6 +76,7 @@ namespace ams::mitm::bluetooth {
             Result EnableBluetooth(void);
             Result GetEventInfo(sf::Out<ams::bluetooth::EventType> out_type, const sf::OutPointerBuffer &out_buffer);
             Result InitializeHid(sf::OutCopyHandle out_handle, u16 version);
+            Result RemoveBond(ams::bluetooth::Address address);
             Result WriteHidData(ams::bluetooth::Address address, const sf::InPointerBuffer &buffer);
             Result GetHidEventInfo(sf::Out<ams::bluetooth::HidEventType> out_type, const sf::OutPointerBuffer &out_buffer);
             Result SetTsi(ams::bluetooth::Address address, u8 tsi);
@@ -81,6 +98,19 @@ namespace ams::mitm::bluetooth {
             void RedirectHidReportEvents(bool redirect);
             void RedirectBleEvents(bool redirect);
             void SignalHidReportRead(void);
+            Result GetControllerStatistics(sf::Out<u32> out_count, const sf::OutBuffer &out_stats);
+            Result GetControllerStateFeed(sf::OutCopyHandle out_handle);
+            Result GetHidReportReadSharedMemory(sf::OutCopyHandle out_handle, sf::OutCopyHandle out_event_handle);
+            Result CreateVirtualController(sf::Out<ams::bluetooth::Address> out_address, sf::OutCopyHandle out_handle, sf::OutCopyHandle out_event_handle);
+            Result DestroyVirtualController(ams::bluetooth::Address address);
+            Result ReloadConfig(void);
+            Result GetBootTimestamps(sf::Out<ams::mitm::BootTimestamps> out_timestamps);
+            Result GetThreadStackUsage(sf::Out<u32> out_count, const sf::OutBuffer &out_usage);
+            Result GetLoadGovernorState(sf::Out<ams::controller::LoadGovernorState> out_state);
+
+        private:
+            ams::bluetooth::Address m_virtual_controllers[ams::controller::MaxVirtualControllers] = {};
+            size_t m_num_virtual_controllers = 0;
     };
     static_assert(IsIBtdrvMitmInterface<BtdrvMitmService>);
 
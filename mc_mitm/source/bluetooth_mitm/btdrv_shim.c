@@ -34,6 +34,10 @@ Result btdrvInitializeHidFwd(Service* srv, Handle *out_handle, u16 version) {
     );
 }
 
+Result btdrvRemoveBondFwd(Service* srv, const BtdrvAddress *address) {
+    return serviceMitmDispatchIn(srv, 11, *address);
+}
+
 Result btdrvWriteHidDataFwd(Service* srv, const BtdrvAddress *address, const BtdrvHidReport *data) {
     return serviceMitmDispatchIn(srv, 19, *address,
         .buffer_attrs = { SfBufferAttr_FixedSize | SfBufferAttr_HipcPointer | SfBufferAttr_In },
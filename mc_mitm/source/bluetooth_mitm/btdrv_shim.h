@@ -23,6 +23,7 @@ extern "C" {
 Result btdrvInitializeBluetoothFwd(Service* srv, Handle *out_handle);
 Result btdrvEnableBluetoothFwd(Service* srv);
 Result btdrvInitializeHidFwd(Service* srv, Handle *out_handle, u16 version);
+Result btdrvRemoveBondFwd(Service* srv, const BtdrvAddress *address);
 Result btdrvWriteHidDataFwd(Service* srv, const BtdrvAddress *address, const BtdrvHidReport *data);
 Result btdrvRegisterHidReportEventFwd(Service* srv, Handle *out_handle);
 Result btdrvGetHidReportEventInfoFwd(Service* srv, Handle *out_handle);
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "btm_device_cache.hpp"
+
+namespace ams::mitm::btm {
+
+    namespace {
+
+        // Bumped whenever the set of connected or paired devices, or their condition, changes
+        std::atomic<u32> g_cache_generation;
+
+    }
+
+    void InvalidateDeviceCache(void) {
+        ++g_cache_generation;
+    }
+
+    u32 GetDeviceCacheGeneration(void) {
+        return g_cache_generation.load();
+    }
+
+}
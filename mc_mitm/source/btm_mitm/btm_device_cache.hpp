@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <atomic>
+#include <mutex>
+#include <cstring>
+
+namespace ams::mitm::btm {
+
+    // Bumps the generation every DeviceCache is compared against, so each refetches on its next use
+    void InvalidateDeviceCache(void);
+    u32 GetDeviceCacheGeneration(void);
+
+    // Holds the response to a btm device query until the cache is invalidated. A fetch that races with an
+    // invalidation is stored against the generation read before it started, so it is refetched on the next call
+    template <typename T>
+    class DeviceCache {
+
+        public:
+            template <typename F>
+            Result Get(T *out, F fetch) {
+                std::scoped_lock lk(m_lock);
+
+                auto generation = GetDeviceCacheGeneration();
+                if (!m_valid || (m_generation != generation)) {
+                    m_valid = false;
+                    R_TRY(fetch(&m_data));
+                    m_generation = generation;
+                    m_valid = true;
+                }
+
+                std::memcpy(out, &m_data, sizeof(T));
+
+                return ams::ResultSuccess();
+            }
+
+        private:
+            os::Mutex m_lock{false};
+            bool m_valid = false;
+            u32 m_generation = 0;
+            T m_data;
+    };
+
+}
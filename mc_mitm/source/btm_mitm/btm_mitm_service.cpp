@@ -22,6 +22,12 @@ namespace ams::mitm::btm {
 
     namespace {
 
+        DeviceCache<BtmDeviceConditionV100> g_device_condition_v100;
+        DeviceCache<BtmDeviceConditionV510> g_device_condition_v510;
+        DeviceCache<BtmDeviceConditionV800> g_device_condition_v800;
+        DeviceCache<BtmDeviceConditionV900> g_device_condition_v900;
+        DeviceCache<BtmDeviceInfoList> g_device_info;
+
         void RenameConnectedDevices(BtmConnectedDevice devices[], size_t count) {
             for (unsigned int i = 0; i < count; ++i) {
                 auto device = &devices[i];
@@ -34,43 +40,57 @@ namespace ams::mitm::btm {
     }
 
     Result BtmMitmService::GetDeviceConditionDeprecated1(sf::Out<ams::btm::DeviceConditionV100> out) {
-        auto device_condition = reinterpret_cast<BtmDeviceConditionV100 *>(out.GetPointer());
-        R_TRY(btmGetDeviceConditionDeprecated1Fwd(this->forward_service.get(), device_condition));
-        RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
-        return ams::ResultSuccess();
+        return g_device_condition_v100.Get(reinterpret_cast<BtmDeviceConditionV100 *>(out.GetPointer()), [this](BtmDeviceConditionV100 *device_condition) {
+            R_TRY(btmGetDeviceConditionDeprecated1Fwd(this->forward_service.get(), device_condition));
+            RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
+            return ams::ResultSuccess();
+        });
     }
 
     Result BtmMitmService::GetDeviceConditionDeprecated2(sf::Out<ams::btm::DeviceConditionV510> out) {
-        auto device_condition = reinterpret_cast<BtmDeviceConditionV510 *>(out.GetPointer());
-        R_TRY(btmGetDeviceConditionDeprecated2Fwd(this->forward_service.get(), device_condition));
-        RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
-        return ams::ResultSuccess();
+        return g_device_condition_v510.Get(reinterpret_cast<BtmDeviceConditionV510 *>(out.GetPointer()), [this](BtmDeviceConditionV510 *device_condition) {
+            R_TRY(btmGetDeviceConditionDeprecated2Fwd(this->forward_service.get(), device_condition));
+            RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
+            return ams::ResultSuccess();
+        });
     }
 
     Result BtmMitmService::GetDeviceConditionDeprecated3(sf::Out<ams::btm::DeviceConditionV800> out) {
-        auto device_condition = reinterpret_cast<BtmDeviceConditionV800 *>(out.GetPointer());
-        R_TRY(btmGetDeviceConditionDeprecated3Fwd(this->forward_service.get(), device_condition));
-        RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
-        return ams::ResultSuccess();
+        return g_device_condition_v800.Get(reinterpret_cast<BtmDeviceConditionV800 *>(out.GetPointer()), [this](BtmDeviceConditionV800 *device_condition) {
+            R_TRY(btmGetDeviceConditionDeprecated3Fwd(this->forward_service.get(), device_condition));
+            RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
+            return ams::ResultSuccess();
+        });
     }
 
     Result BtmMitmService::GetDeviceCondition(sf::Out<ams::btm::DeviceCondition> out) {
-        auto device_condition = reinterpret_cast<BtmDeviceConditionV900 *>(out.GetPointer());
-        R_TRY(btmGetDeviceConditionFwd(this->forward_service.get(), device_condition));
-        RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
-        return ams::ResultSuccess();
+        return g_device_condition_v900.Get(reinterpret_cast<BtmDeviceConditionV900 *>(out.GetPointer()), [this](BtmDeviceConditionV900 *device_condition) {
+            R_TRY(btmGetDeviceConditionFwd(this->forward_service.get(), device_condition));
+            RenameConnectedDevices(device_condition->devices, device_condition->connected_count);
+            return ams::ResultSuccess();
+        });
     }
 
     Result BtmMitmService::GetDeviceInfo(sf::Out<ams::btm::DeviceInfoList> out) {
-        auto device_info = reinterpret_cast<BtmDeviceInfoList *>(out.GetPointer());
-        R_TRY(btmGetDeviceInfoFwd(this->forward_service.get(), device_info));
+        return g_device_info.Get(reinterpret_cast<BtmDeviceInfoList *>(out.GetPointer()), [this](BtmDeviceInfoList *device_info) {
+            R_TRY(btmGetDeviceInfoFwd(this->forward_service.get(), device_info));
 
-        for (unsigned int i = 0; i < device_info->device_count; ++i) {
-            auto device = &device_info->devices[i];
-            if (!controller::IsOfficialSwitchControllerName(device->name.name)) {
-                std::strncpy(device->name.name, controller::pro_controller_name, sizeof(device->name) - 1);
+            for (unsigned int i = 0; i < device_info->device_count; ++i) {
+                auto device = &device_info->devices[i];
+                if (!controller::IsOfficialSwitchControllerName(device->name.name)) {
+                    std::strncpy(device->name.name, controller::pro_controller_name, sizeof(device->name) - 1);
+                }
             }
-        }
+
+            return ams::ResultSuccess();
+        });
+    }
+
+    Result BtmMitmService::RemoveDeviceInfo(ams::bluetooth::Address address) {
+        R_TRY(btmRemoveDeviceInfoFwd(this->forward_service.get(), &address));
+
+        // Only invalidate once btm has removed the device, so a query in between can't cache it again
+        InvalidateDeviceCache();
 
         return ams::ResultSuccess();
     }
@@ -16,6 +16,8 @@
 #pragma once
 #include <stratosphere.hpp>
 #include "btm/btm_types.hpp"
+#include "btm_device_cache.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
 
 #define AMS_BTM_MITM_INTERFACE_INFO(C, H)                                                                                                                            \
     AMS_SF_METHOD_INFO(C, H, 3,  Result, GetDeviceConditionDeprecated1, (sf::Out<ams::btm::DeviceConditionV100> out), (out), hos::Version_1_0_0, hos::Version_5_0_2) \
@@ -23,6 +25,7 @@
     AMS_SF_METHOD_INFO(C, H, 3,  Result, GetDeviceConditionDeprecated3, (sf::Out<ams::btm::DeviceConditionV800> out), (out), hos::Version_8_0_0, hos::Version_8_1_1) \
     AMS_SF_METHOD_INFO(C, H, 3,  Result, GetDeviceCondition,            (sf::Out<ams::btm::DeviceCondition> out),     (out), hos::Version_9_0_0)                     \
     AMS_SF_METHOD_INFO(C, H, 9,  Result, GetDeviceInfo,                 (sf::Out<ams::btm::DeviceInfoList> out),      (out))                                         \
+    AMS_SF_METHOD_INFO(C, H, 11, Result, RemoveDeviceInfo,              (ams::bluetooth::Address address),            (address))                                     \
 
 AMS_SF_DEFINE_MITM_INTERFACE(ams::mitm::btm, IBtmMitmInterface, AMS_BTM_MITM_INTERFACE_INFO)
 
@@ -44,6 +47,7 @@ namespace ams::mitm::btm {
             Result GetDeviceConditionDeprecated3(sf::Out<ams::btm::DeviceConditionV800> out);
             Result GetDeviceCondition(sf::Out<ams::btm::DeviceCondition> out);
             Result GetDeviceInfo(sf::Out<ams::btm::DeviceInfoList> out);
+            Result RemoveDeviceInfo(ams::bluetooth::Address address);
     };
     static_assert(IsIBtmMitmInterface<BtmMitmService>);
 
@@ -50,3 +50,7 @@ Result btmGetDeviceInfoFwd(Service* s, BtmDeviceInfoList *devices) {
         .buffers = { {devices, sizeof(BtmDeviceInfoList)} }
     );
 }
+
+Result btmRemoveDeviceInfoFwd(Service* s, const BtdrvAddress *address) {
+    return serviceMitmDispatchIn(s, 11, *address);
+}
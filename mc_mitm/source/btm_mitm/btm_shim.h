@@ -25,6 +25,7 @@ Result btmGetDeviceConditionDeprecated2Fwd(Service* s, BtmDeviceConditionV510 *c
 Result btmGetDeviceConditionDeprecated3Fwd(Service* s, BtmDeviceConditionV800 *condition);
 Result btmGetDeviceConditionFwd(Service* s, BtmDeviceConditionV900 *condition);
 Result btmGetDeviceInfoFwd(Service* s, BtmDeviceInfoList *devices);
+Result btmRemoveDeviceInfoFwd(Service* s, const BtdrvAddress *address);
 
 #ifdef __cplusplus
 }
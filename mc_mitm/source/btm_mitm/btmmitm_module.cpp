@@ -69,6 +69,7 @@ namespace ams::mitm::btm {
     }
 
     Result Launch(void) {
+        utils::PaintThreadStack("btm_mitm", g_btm_mitm_thread_stack, sizeof(g_btm_mitm_thread_stack));
         R_TRY(os::CreateThread(&g_btm_mitm_thread,
             BtmMitmThreadFunction,
             nullptr,
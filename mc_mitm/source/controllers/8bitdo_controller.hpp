@@ -18,7 +18,8 @@
 
 namespace ams::controller {
 
-    enum EightBitDoReportFormat {
+    enum EightBitDoReportFormat : uint8_t {
+        EightBitDoReportFormat_Unknown,
         EightBitDoReportFormat_ZeroV1,
         EightBitDoReportFormat_ZeroV2,
         EightBitDoReportFormat_Other
@@ -136,7 +137,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class EightBitDoController : public EmulatedSwitchController {
+    class EightBitDoController : public EmulatedSwitchControllerImpl<EightBitDoController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -145,14 +146,28 @@ namespace ams::controller {
             };  
 
             EightBitDoController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address)
+                , m_input0x01_handler(&EightBitDoController::DetectInputReport)
+                , m_input0x03_handler(&EightBitDoController::DetectInputReport) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
         private:
-            void HandleInputReport0x01(const EightBitDoReportData *src, EightBitDoReportFormat fmt);
-            void HandleInputReport0x03(const EightBitDoReportData *src, EightBitDoReportFormat);
+            static EightBitDoReportFormat DetectReportFormat(const bluetooth::HidReport *report);
+            void BindReportFormat(EightBitDoReportFormat format);
+
+            void DetectInputReport(const bluetooth::HidReport *report);
+            void HandleInputReport0x01V1(const bluetooth::HidReport *report);
+            void HandleInputReport0x01V2(const bluetooth::HidReport *report);
+            void HandleInputReport0x03V1(const bluetooth::HidReport *report);
+            void HandleInputReport0x03V2(const bluetooth::HidReport *report);
+
+            // Bound to the handlers for the detected format. Each handler only checks the report size, redetecting if the shape changes
+            void (EightBitDoController::*m_input0x01_handler)(const bluetooth::HidReport *report);
+            void (EightBitDoController::*m_input0x03_handler)(const bluetooth::HidReport *report);
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<EightBitDoController>;
+
 }
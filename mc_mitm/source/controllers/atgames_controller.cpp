@@ -71,4 +71,6 @@ namespace ams::controller {
         m_buttons.plus  = src->input0x01.home_twirl;
     }
 
+    template class EmulatedSwitchControllerImpl<AtGamesController>;
+
 }
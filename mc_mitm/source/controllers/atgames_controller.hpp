@@ -65,7 +65,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class AtGamesController : public EmulatedSwitchController {
+    class AtGamesController : public EmulatedSwitchControllerImpl<AtGamesController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -73,7 +73,7 @@ namespace ams::controller {
             };  
 
             AtGamesController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -82,4 +82,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<AtGamesController>;
+
 }
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "button_combos.hpp"
+#include "shared_table_pool.hpp"
+#include <bit>
+
+namespace ams::controller {
+
+    namespace {
+
+        // Combos a table was compiled from, zero padded so identical configs compare equal
+        struct ButtonComboKey {
+            mitm::ButtonComboConfig combos[mitm::MaxButtonCombos];
+            size_t count;
+        };
+
+        // Controllers sharing a profile share its table. Controllers configured once the pool is exhausted evaluate their combos in order
+        constexpr size_t MaxButtonComboTables = 4;
+        SharedTablePool<ButtonComboKey, ButtonComboTable, MaxButtonComboTables> g_combo_tables;
+
+        void CompileButtonComboTable(const ButtonComboKey *key, uint32_t chord_mask, ButtonComboTable *table) {
+            // Table index bit for each chord button
+            uint32_t chord_buttons[MaxComboChordButtons];
+            size_t num_chord_buttons = 0;
+            for (uint32_t mask = chord_mask; mask != 0; mask &= mask - 1)
+                chord_buttons[num_chord_buttons++] = mask & -mask;
+
+            for (size_t byte = 0; byte < 3; ++byte) {
+                for (uint32_t value = 0; value < 0x100; ++value) {
+                    uint8_t index = 0;
+                    for (size_t i = 0; i < num_chord_buttons; ++i) {
+                        if ((value << (8 * byte)) & chord_buttons[i])
+                            index |= BIT(i);
+                    }
+
+                    table->index_lut[byte][value] = index;
+                }
+            }
+
+            for (uint32_t index = 0; index < BIT(num_chord_buttons); ++index) {
+                uint32_t buttons = 0;
+                for (size_t i = 0; i < num_chord_buttons; ++i) {
+                    if (index & BIT(i))
+                        buttons |= chord_buttons[i];
+                }
+
+                auto entry = &table->entries[index];
+                *entry = {};
+
+                // Outputs of earlier combos can complete the chord of a later one, so include all of them when looking for hold times that could apply
+                uint32_t reachable = buttons;
+                for (size_t i = 0; i < key->count; ++i) {
+                    auto& combo = key->combos[i];
+                    if ((reachable & combo.chord) == combo.chord) {
+                        if (combo.hold_ms > 0)
+                            entry->hold = 1;
+
+                        reachable |= combo.output;
+                    }
+                }
+
+                if (entry->hold)
+                    continue;
+
+                // Without hold times the outcome only depends on the chord buttons held
+                for (size_t i = 0; i < key->count; ++i) {
+                    auto& combo = key->combos[i];
+                    if ((buttons & combo.chord) != combo.chord)
+                        continue;
+
+                    buttons = (buttons & ~combo.chord) | combo.output;
+                    entry->outputs |= combo.output;
+                    entry->fired |= combo.chord;
+                }
+
+                entry->buttons = buttons;
+            }
+        }
+
+    }
+
+    ButtonCombos::ButtonCombos(void)
+    : m_count(0)
+    , m_table(nullptr)
+    , m_chord_mask(0)
+    , m_suppressed(0)
+    , m_holding(0) { }
+
+    ButtonCombos::~ButtonCombos(void) {
+        g_combo_tables.Release(m_table);
+    }
+
+    void ButtonCombos::Configure(const mitm::ButtonComboConfig *combos, size_t count) {
+        g_combo_tables.Release(m_table);
+        m_table = nullptr;
+
+        m_count = std::min(count, mitm::MaxButtonCombos);
+        m_chord_mask = 0;
+        m_suppressed = 0;
+        m_holding = 0;
+
+        ButtonComboKey key = {};
+        key.count = m_count;
+
+        for (size_t i = 0; i < m_count; ++i) {
+            m_combos[i].chord = combos[i].chord;
+            m_combos[i].output = combos[i].output;
+            m_combos[i].hold = os::ConvertToTick(TimeSpan::FromMilliSeconds(combos[i].hold_ms));
+            m_chord_mask |= combos[i].chord;
+            key.combos[i] = combos[i];
+        }
+
+        if ((m_count > 0) && (std::popcount(m_chord_mask) <= int(MaxComboChordButtons))) {
+            m_table = g_combo_tables.Acquire(&key, [this, &key](ButtonComboTable *table) {
+                CompileButtonComboTable(&key, m_chord_mask, table);
+            });
+        }
+    }
+
+    uint32_t ButtonCombos::Apply(uint32_t buttons) {
+        // Stop suppressing chord buttons once they have been released
+        m_suppressed &= buttons;
+
+        if (!m_table)
+            return this->ApplyInOrder(buttons);
+
+        auto& entry = m_table->entries[m_table->index_lut[0][buttons & 0xff]
+                                     | m_table->index_lut[1][(buttons >> 8) & 0xff]
+                                     | m_table->index_lut[2][(buttons >> 16) & 0xff]];
+        if (entry.hold)
+            return this->ApplyInOrder(buttons);
+
+        // No combo with a hold time can be matched
+        m_holding = 0;
+
+        // Chord buttons of combos triggered by this report are already cleared in the entry unless another combo outputs them
+        buttons = ((buttons & ~m_chord_mask) | entry.buttons) & ~(m_suppressed & ~entry.outputs);
+        m_suppressed |= entry.fired;
+
+        return buttons;
+    }
+
+    uint32_t ButtonCombos::ApplyInOrder(uint32_t buttons) {
+        // Nothing can match unless a chord button is held
+        if (((buttons & m_chord_mask) == 0) && (m_holding == 0))
+            return buttons;
+
+        // Only read the clock once a combo with a hold time needs it
+        os::Tick now(0);
+
+        uint32_t outputs = 0;
+        for (size_t i = 0; i < m_count; ++i) {
+            auto& combo = m_combos[i];
+
+            if ((buttons & combo.chord) != combo.chord) {
+                m_holding &= ~BIT(i);
+                continue;
+            }
+
+            if (combo.hold.GetInt64Value() > 0) {
+                if (now.GetInt64Value() == 0)
+                    now = os::GetSystemTick();
+
+                if ((m_holding & BIT(i)) == 0) {
+                    m_holding |= BIT(i);
+                    m_hold_start[i] = now;
+                }
+
+                // Pass the chord through until it has been held long enough
+                if ((now - m_hold_start[i]) < combo.hold)
+                    continue;
+            }
+
+            // Combos are evaluated in order, so the output of one can form part of the chord of another
+            buttons = (buttons & ~combo.chord) | combo.output;
+            outputs |= combo.output;
+            m_suppressed |= combo.chord;
+        }
+
+        return buttons & ~(m_suppressed & ~outputs);
+    }
+
+}
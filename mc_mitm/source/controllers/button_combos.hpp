@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include "../mcmitm_config.hpp"
+
+namespace ams::controller {
+
+    // Maximum number of distinct buttons across a profile's chords for its combos to be compiled into a lookup table
+    constexpr size_t MaxComboChordButtons = 8;
+
+    // Outcome of evaluating every combo in order against one combination of held chord buttons
+    struct ButtonComboTableEntry {
+        uint32_t buttons : 24;  // Chord and output buttons reported
+        uint32_t hold    : 1;   // A combo with a hold time could match, so the combos must be evaluated in order
+        uint32_t fired;         // Chord buttons of triggered combos
+        uint32_t outputs;       // Output buttons of triggered combos
+    };
+
+    struct ButtonComboTable {
+        uint8_t index_lut[3][0x100];    // Gathers the held chord buttons of each byte of the button mask into a table index
+        ButtonComboTableEntry entries[BIT(MaxComboChordButtons)];
+    };
+
+    // Evaluates a profile's button combos against a 24-bit button mask. Combos are compiled into a table indexed by the held
+    // chord buttons when configured, so the per-report cost is three loads to build the index and one to fetch the outcome,
+    // however many combos are defined. Combos are only evaluated in order while a chord with a hold time could be held
+    class ButtonCombos {
+
+        public:
+            ButtonCombos(void);
+            ~ButtonCombos(void);
+
+            ButtonCombos(const ButtonCombos &) = delete;
+            ButtonCombos &operator=(const ButtonCombos &) = delete;
+
+            void Configure(const mitm::ButtonComboConfig *combos, size_t count);
+            bool IsEnabled(void) const { return m_count > 0; }
+            bool IsCompiled(void) const { return m_table != nullptr; }
+            uint32_t Apply(uint32_t buttons);
+
+        private:
+            uint32_t ApplyInOrder(uint32_t buttons);
+
+            struct Combo {
+                uint32_t chord;
+                uint32_t output;
+                os::Tick hold;
+            };
+
+            Combo m_combos[mitm::MaxButtonCombos];
+            size_t m_count;
+            const ButtonComboTable *m_table;
+
+            uint32_t m_chord_mask;  // Union of all chord buttons
+            uint32_t m_suppressed;  // Chord buttons of triggered combos, masked out until released
+            uint32_t m_holding;     // Combos currently waiting on their hold time
+            os::Tick m_hold_start[mitm::MaxButtonCombos];
+    };
+
+}
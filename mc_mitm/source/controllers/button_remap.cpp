@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "button_remap.hpp"
+#include "shared_table_pool.hpp"
+
+namespace ams::controller {
+
+    namespace {
+
+        struct ButtonRemapKey {
+            uint32_t button_map[mitm::NumSwitchButtonBits];
+        };
+
+        // Controllers configured once the pool is exhausted apply their button map one bit at a time
+        constexpr size_t MaxButtonRemapTables = 4;
+        SharedTablePool<ButtonRemapKey, ButtonRemapTable, MaxButtonRemapTables> g_remap_tables;
+
+        // Expand the per-bit button map into three byte indexed tables so remapping costs three lookups per report
+        void CompileButtonRemapTable(const ButtonRemapKey *key, ButtonRemapTable *table) {
+            for (size_t byte = 0; byte < 3; ++byte) {
+                for (uint32_t value = 0; value < 0x100; ++value) {
+                    uint32_t mask = 0;
+                    for (size_t bit = 0; bit < 8; ++bit) {
+                        if (value & BIT(bit))
+                            mask |= key->button_map[8*byte + bit];
+                    }
+
+                    table->lut[byte][value] = mask;
+                }
+            }
+        }
+
+    }
+
+    ButtonRemap::~ButtonRemap(void) {
+        g_remap_tables.Release(m_table);
+    }
+
+    void ButtonRemap::Configure(const mitm::ControllerProfileConfig *profile) {
+        g_remap_tables.Release(m_table);
+        m_table = nullptr;
+        m_button_map = nullptr;
+
+        if (!profile || !profile->remap_buttons)
+            return;
+
+        m_button_map = profile->button_map;
+
+        ButtonRemapKey key;
+        std::memcpy(key.button_map, profile->button_map, sizeof(key.button_map));
+        m_table = g_remap_tables.Acquire(&key, [&key](ButtonRemapTable *table) {
+            CompileButtonRemapTable(&key, table);
+        });
+    }
+
+    uint32_t ButtonRemap::ApplyButtonMap(uint32_t buttons) const {
+        uint32_t mask = 0;
+        for (; buttons != 0; buttons &= buttons - 1)
+            mask |= m_button_map[__builtin_ctz(buttons)];
+
+        return mask;
+    }
+
+}
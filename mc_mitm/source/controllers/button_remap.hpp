@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include "../mcmitm_config.hpp"
+
+namespace ams::controller {
+
+    // Output masks for each value of each byte of the 24-bit button mask
+    struct ButtonRemapTable {
+        uint32_t lut[3][0x100];
+    };
+
+    // Applies a button permutation compiled into per-byte lookup tables, at a fixed cost of three loads per report. Tables are
+    // shared by every controller with the same remaps rather than stored with each profile
+    class ButtonRemap {
+
+        public:
+            ButtonRemap(void) : m_table(nullptr), m_button_map(nullptr) { };
+            ~ButtonRemap(void);
+
+            ButtonRemap(const ButtonRemap &) = delete;
+            ButtonRemap &operator=(const ButtonRemap &) = delete;
+
+            void Configure(const mitm::ControllerProfileConfig *profile);
+
+            bool IsEnabled(void) const { return m_button_map != nullptr; }
+            bool IsCompiled(void) const { return m_table != nullptr; }
+
+            uint32_t Apply(uint32_t buttons) const {
+                if (!m_table)
+                    return this->ApplyButtonMap(buttons);
+
+                return m_table->lut[0][buttons & 0xff] | m_table->lut[1][(buttons >> 8) & 0xff] | m_table->lut[2][(buttons >> 16) & 0xff];
+            }
+
+        private:
+            uint32_t ApplyButtonMap(uint32_t buttons) const;
+
+            const ButtonRemapTable *m_table;
+            const uint32_t *m_button_map;   // Points into the config snapshot the controller was configured from
+    };
+
+}
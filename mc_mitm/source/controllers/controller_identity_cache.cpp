@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_identity_cache.hpp"
+#include "../mcmitm_version.hpp"
+#include <mutex>
+#include <cstring>
+
+namespace ams::controller {
+
+    namespace {
+
+        constexpr const char *identity_cache_mount_name = "mc_cache";
+        constexpr const char *identity_cache_directory = "mc_cache:/config/MissionControl";
+        constexpr const char *identity_cache_location = "mc_cache:/config/MissionControl/identity_cache.bin";
+
+        constexpr u32 identity_cache_magic = util::FourCC<'M','C','I','D'>::Code;
+
+        // Batch up writes from several devices connecting at once
+        constexpr auto write_back_delay = TimeSpan::FromSeconds(2);
+
+        struct IdentityCacheHeader {
+            u32 magic;
+            u32 version;
+            u32 count;
+            u32 reserved;
+            char build_version[0x30];   // Build that wrote the cache, truncated if need be
+        };
+
+        struct IdentityCacheFile {
+            IdentityCacheHeader header;
+            ControllerIdentity entries[MaxIdentityCacheEntries];
+        };
+
+        // Waited on by the bluetooth event thread, which writes the cache back when it fires
+        os::TimerEvent g_write_back_event(os::EventClearMode_ManualClear);
+
+        os::Mutex g_cache_lock(false);
+        IdentityCacheFile g_cache;      // Entries are kept most recently identified first
+        IdentityCacheFile g_write_buffer;
+
+        inline bool bdcmp(const bluetooth::Address *addr1, const bluetooth::Address *addr2) {
+            return std::memcmp(addr1, addr2, sizeof(bluetooth::Address)) == 0;
+        }
+
+        // Removes an entry, returning whether it was present. Must be called with g_cache_lock held
+        bool RemoveEntry(const bluetooth::Address *address) {
+            for (size_t i = 0; i < g_cache.header.count; ++i) {
+                if (bdcmp(&g_cache.entries[i].address, address)) {
+                    std::memmove(&g_cache.entries[i], &g_cache.entries[i + 1], (g_cache.header.count - i - 1) * sizeof(ControllerIdentity));
+                    --g_cache.header.count;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void LoadCacheFile(void) {
+            if (R_FAILED(fs::MountSdCard(identity_cache_mount_name))) {
+                return;
+            }
+            ON_SCOPE_EXIT { fs::Unmount(identity_cache_mount_name); };
+
+            fs::FileHandle file;
+            if (R_FAILED(fs::OpenFile(std::addressof(file), identity_cache_location, fs::OpenMode_Read))) {
+                return;
+            }
+            ON_SCOPE_EXIT { fs::CloseFile(file); };
+
+            size_t read_size;
+            if (R_FAILED(fs::ReadFile(std::addressof(read_size), file, 0, &g_write_buffer, sizeof(g_write_buffer)))) {
+                return;
+            }
+
+            // Discard anything written by a different build rather than trusting stale types
+            auto header = &g_write_buffer.header;
+            if ((read_size < sizeof(IdentityCacheHeader)) || (header->magic != identity_cache_magic) || (header->version != IdentityCacheVersion) ||
+                (std::strncmp(header->build_version, g_cache.header.build_version, sizeof(header->build_version)) != 0) ||
+                (header->count > MaxIdentityCacheEntries) || (read_size < sizeof(IdentityCacheHeader) + header->count * sizeof(ControllerIdentity))) {
+                return;
+            }
+
+            std::memcpy(&g_cache, &g_write_buffer, sizeof(g_cache));
+        }
+
+        Result WriteCacheFile(void) {
+            {
+                std::scoped_lock lk(g_cache_lock);
+                std::memcpy(&g_write_buffer, &g_cache, sizeof(g_write_buffer));
+            }
+
+            auto size = sizeof(IdentityCacheHeader) + g_write_buffer.header.count * sizeof(ControllerIdentity);
+
+            R_TRY(fs::MountSdCard(identity_cache_mount_name));
+            ON_SCOPE_EXIT { fs::Unmount(identity_cache_mount_name); };
+
+            // These fail harmlessly if the directory or file already exist
+            fs::CreateDirectory(identity_cache_directory);
+            fs::CreateFile(identity_cache_location, 0);
+
+            fs::FileHandle file;
+            R_TRY(fs::OpenFile(std::addressof(file), identity_cache_location, fs::OpenMode_Write));
+            ON_SCOPE_EXIT { fs::CloseFile(file); };
+
+            R_TRY(fs::SetFileSize(file, size));
+            R_TRY(fs::WriteFile(file, 0, &g_write_buffer, size, fs::WriteOption::Flush));
+
+            return ams::ResultSuccess();
+        }
+
+    }
+
+    Result InitializeIdentityCache(void) {
+        g_cache.header.magic = identity_cache_magic;
+        g_cache.header.version = IdentityCacheVersion;
+        g_cache.header.count = 0;
+        std::strncpy(g_cache.header.build_version, mitm::version_string, sizeof(g_cache.header.build_version) - 1);
+
+        LoadCacheFile();
+
+        return ams::ResultSuccess();
+    }
+
+    os::TimerEvent *GetWriteBackEvent(void) {
+        return &g_write_back_event;
+    }
+
+    void WriteBackIdentityCache(void) {
+        // A failed write is retried the next time the cache changes
+        WriteCacheFile();
+    }
+
+    bool LookupIdentity(const bluetooth::Address *address, ControllerIdentity *out) {
+        std::scoped_lock lk(g_cache_lock);
+
+        for (size_t i = 0; i < g_cache.header.count; ++i) {
+            if (bdcmp(&g_cache.entries[i].address, address)) {
+                *out = g_cache.entries[i];
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void StoreIdentity(const ControllerIdentity *identity) {
+        {
+            std::scoped_lock lk(g_cache_lock);
+
+            // Move the entry to the front, dropping the least recently identified device if full
+            if (!RemoveEntry(&identity->address) && (g_cache.header.count == MaxIdentityCacheEntries))
+                --g_cache.header.count;
+
+            std::memmove(&g_cache.entries[1], &g_cache.entries[0], g_cache.header.count * sizeof(ControllerIdentity));
+            g_cache.entries[0] = *identity;
+            ++g_cache.header.count;
+        }
+
+        g_write_back_event.StartOneShot(write_back_delay);
+    }
+
+    void InvalidateIdentity(const bluetooth::Address *address) {
+        bool removed;
+        {
+            std::scoped_lock lk(g_cache_lock);
+            removed = RemoveEntry(address);
+        }
+
+        if (removed)
+            g_write_back_event.StartOneShot(write_back_delay);
+    }
+
+}
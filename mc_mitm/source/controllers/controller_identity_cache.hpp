@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::controller {
+
+    // Bump whenever the layout of the cache file changes. Caches written by a different build are discarded too, since eg. ControllerType
+    // values may have been reordered
+    constexpr u32 IdentityCacheVersion = 5;
+    constexpr size_t MaxIdentityCacheEntries = 32;
+
+    struct ControllerIdentity {
+        bluetooth::Address address;
+        uint8_t type;   // ControllerType
+        uint16_t vid;
+        uint16_t pid;
+        uint8_t reserved[5];
+    } __attribute__ ((__packed__));
+    static_assert(sizeof(ControllerIdentity) == 16);
+
+    Result InitializeIdentityCache(void);
+
+    // Signalled a short while after the cache last changed, so that writes from several devices connecting at once are batched
+    os::TimerEvent *GetWriteBackEvent(void);
+    void WriteBackIdentityCache(void);
+
+    bool LookupIdentity(const bluetooth::Address *address, ControllerIdentity *out);
+    void StoreIdentity(const ControllerIdentity *identity);
+    void InvalidateIdentity(const bluetooth::Address *address);
+
+}
@@ -15,10 +15,12 @@
  */
 #include "controller_management.hpp"
 #include <stratosphere.hpp>
+#include "../mcmitm_initialization.hpp"
 #include <memory>
 #include <mutex>
 #include <vector>
 #include <cstring>
+#include <atomic>
 
 namespace ams::controller {
 
@@ -42,6 +44,23 @@ namespace ams::controller {
         os::Mutex g_controller_lock(false);
         std::vector<std::unique_ptr<SwitchController>> g_controllers;
 
+        // Controllers that asked to be serviced again at the last scan. Only touched by the report thread
+        size_t g_paced_controllers;
+
+        // Config snapshot the controllers are currently configured from. Only replaced with g_controller_lock held
+        std::atomic<const mitm::MissionControlConfig *> g_config;
+
+        const mitm::MissionControlConfig *GetControllerConfig(void) {
+            auto config = g_config.load(std::memory_order_relaxed);
+            if (!config) {
+                config = mitm::AcquireConfig();
+                g_config.store(config, std::memory_order_relaxed);
+                SetLoadBudget(config->misc.cpu_budget_percent);
+            }
+
+            return config;
+        }
+
         inline bool bdcmp(const bluetooth::Address *addr1, const bluetooth::Address *addr2) {
             return std::memcmp(addr1, addr2, sizeof(bluetooth::Address)) == 0;
         }
@@ -172,6 +191,11 @@ namespace ams::controller {
                 return ControllerType_AtGames;
             }
         }
+
+        // Anything else presenting itself purely as a keyboard is translated as one, eg. arcade stick encoders. Combined classes
+        // such as keyboard + gamepad (0x48) don't necessarily send boot keyboard reports
+        if ((device->class_of_device.class_of_device[2] & 0xfc) == cod_minor_keyboard)
+            return ControllerType_Keyboard;
 		
         return ControllerType_Unknown;
     }
@@ -181,6 +205,10 @@ namespace ams::controller {
                (((cod->class_of_device[2] & 0x0f) == cod_minor_gamepad) || ((cod->class_of_device[2] & 0x0f) == cod_minor_joystick) || ((cod->class_of_device[2] & 0x40) == cod_minor_keyboard));
     }
 
+    bool IsPeripheralDeviceClass(const bluetooth::DeviceClass *cod) {
+        return (cod->class_of_device[1] & 0x0f) == cod_major_peripheral;
+    }
+
     bool IsOfficialSwitchControllerName(const std::string& name) {
         for (auto n : official_npad_names) {
             if (name.rfind(n, 0) == 0)
@@ -191,12 +219,27 @@ namespace ams::controller {
     }
 
     void AttachHandler(const bluetooth::Address *address) {
-        std::scoped_lock lk(g_controller_lock);
+        // Reconnecting devices are identified from the cache, skipping the btdrv round trip
+        ControllerIdentity identity;
+        if (!LookupIdentity(address, &identity)) {
+            bluetooth::DevicesSettings device;
+            R_ABORT_UNLESS(btdrvGetPairedDeviceInfo(*address, &device));
+
+            identity = {};
+            identity.address = *address;
+            identity.type = Identify(&device);
+            identity.vid = device.vid;
+            identity.pid = device.pid;
+
+            // Unrecognised devices are identified again on reconnect, in case a later build or config learns to handle them
+            if (identity.type != ControllerType_Unknown)
+                StoreIdentity(&identity);
+        }
 
-        bluetooth::DevicesSettings device;
-        R_ABORT_UNLESS(btdrvGetPairedDeviceInfo(*address, &device));
+        std::scoped_lock lk(g_controller_lock);
 
-        switch (Identify(&device)) {
+        auto type = static_cast<ControllerType>(identity.type);
+        switch (type) {
             case ControllerType_Switch:
                 g_controllers.push_back(std::make_unique<SwitchController>(address));
                 break;
@@ -260,12 +303,21 @@ namespace ams::controller {
             case ControllerType_AtGames:
                 g_controllers.push_back(std::make_unique<AtGamesController>(address));
                 break;
+            case ControllerType_Keyboard:
+                g_controllers.push_back(std::make_unique<KeyboardController>(address));
+                break;
             default:
                 g_controllers.push_back(std::make_unique<UnknownController>(address));
                 break;
         }
 
+        auto config = GetControllerConfig();
+        g_controllers.back()->SetHardwareId({identity.vid, identity.pid});
+        g_controllers.back()->SetProfile(config, mitm::FindControllerProfile(config, address, identity.vid, identity.pid));
+        g_controllers.back()->SetStateSlot(AcquireStateSlot(address, type));
         g_controllers.back()->Initialize();
+
+        mitm::RecordBootPhase(mitm::BootPhase_FirstControllerAttached);
     }
 
     void RemoveHandler(const bluetooth::Address *address) {
@@ -273,6 +325,7 @@ namespace ams::controller {
 
         for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
             if (bdcmp(&(*it)->Address(), address)) {
+                ReleaseStateSlot((*it)->GetStateSlot());
                 g_controllers.erase(it);
                 return;
             }
@@ -291,4 +344,132 @@ namespace ams::controller {
         return nullptr;
     }
 
+    void SetTsi(const bluetooth::Address *address, uint8_t tsi) {
+        std::scoped_lock lk(g_controller_lock);
+
+        // Looked up under the lock so the controller can't be removed while the tsi is applied
+        for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
+            if (bdcmp(&(*it)->Address(), address)) {
+                (*it)->SetTsi(tsi);
+                return;
+            }
+        }
+    }
+
+    Result AttachVirtualHandler(bluetooth::Address *address, Handle *out_handle) {
+        std::scoped_lock lk(g_controller_lock);
+
+        // Pick the first virtual address not already in use
+        for (size_t i = 0; i < MaxVirtualControllers; ++i) {
+            *address = VirtualController::address_prefix;
+            address->address[5] = i;
+
+            bool in_use = false;
+            for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
+                if (bdcmp(&(*it)->Address(), address)) {
+                    in_use = true;
+                    break;
+                }
+            }
+
+            if (in_use)
+                continue;
+
+            auto controller = std::make_unique<VirtualController>(address);
+            R_TRY(controller->Initialize());
+
+            auto config = GetControllerConfig();
+            controller->SetProfile(config, mitm::FindControllerProfile(config, address, 0, 0));
+            controller->SetStateSlot(AcquireStateSlot(address, ControllerType_Virtual));
+            *out_handle = controller->GetSharedMemoryHandle();
+
+            g_controllers.push_back(std::move(controller));
+
+            return ams::ResultSuccess();
+        }
+
+        return -1;
+    }
+
+    Result RemoveVirtualHandler(const bluetooth::Address *address) {
+        if (!VirtualController::IsVirtualAddress(address))
+            return -1;
+
+        std::scoped_lock lk(g_controller_lock);
+
+        for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
+            if (bdcmp(&(*it)->Address(), address)) {
+                ReleaseStateSlot((*it)->GetStateSlot());
+                g_controllers.erase(it);
+                return ams::ResultSuccess();
+            }
+        }
+
+        return -1;
+    }
+
+    void ApplyConfigUpdates(void) {
+        // The common case is a single pointer comparison against the snapshot already in use
+        auto config = g_config.load(std::memory_order_relaxed);
+        if (!config || mitm::IsCurrentConfig(config))
+            return;
+
+        std::scoped_lock lk(g_controller_lock);
+
+        auto new_config = mitm::AcquireConfig();
+        for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
+            auto id = (*it)->GetHardwareId();
+            (*it)->SetProfile(new_config, mitm::FindControllerProfile(new_config, &(*it)->Address(), id.vid, id.pid));
+        }
+
+        SetLoadBudget(new_config->misc.cpu_budget_percent);
+
+        // Nothing references the old snapshot any more
+        g_config.store(new_config, std::memory_order_relaxed);
+        mitm::ReleaseConfig(config);
+    }
+
+    bool ServicePacedControllers(TimeSpan *timeout) {
+        // Nothing to do after most reports, unless a controller has started pacing or held something back since the last scan
+        if (!ConsumePacingServiceRequest() && (g_paced_controllers == 0))
+            return false;
+
+        std::scoped_lock lk(g_controller_lock);
+
+        auto now = os::GetSystemTick();
+
+        g_paced_controllers = 0;
+        os::Tick next_deadline;
+        for (auto it = g_controllers.begin(); it < g_controllers.end(); ++it) {
+            os::Tick deadline;
+            if ((*it)->ServicePacing(now, &deadline)) {
+                if ((g_paced_controllers == 0) || (deadline < next_deadline))
+                    next_deadline = deadline;
+
+                ++g_paced_controllers;
+            }
+        }
+
+        if (g_paced_controllers == 0)
+            return false;
+
+        *timeout = next_deadline > now ? os::ConvertToTimeSpan(next_deadline - now) : TimeSpan::FromNanoSeconds(0);
+        return true;
+    }
+
+    size_t GetControllerStatistics(ControllerStatistics *stats, size_t max_count) {
+        std::scoped_lock lk(g_controller_lock);
+
+        size_t count = 0;
+        for (auto it = g_controllers.begin(); (it < g_controllers.end()) && (count < max_count); ++it, ++count) {
+            stats[count] = {};
+            stats[count].address = (*it)->Address();
+            (*it)->GetStats()->GetSnapshot(&stats[count]);
+        }
+
+        return count;
+    }
+
+    template class EmulatedSwitchControllerImpl<UnknownController>;
+
 }
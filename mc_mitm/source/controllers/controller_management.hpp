@@ -18,6 +18,9 @@
 #include <string>
 
 #include "switch_controller.hpp"
+#include "controller_state_feed.hpp"
+#include "controller_identity_cache.hpp"
+#include "load_governor.hpp"
 #include "wii_controller.hpp"
 #include "dualshock4_controller.hpp"
 #include "dualsense_controller.hpp"
@@ -38,12 +41,15 @@
 #include "icade_controller.hpp"
 #include "lanshen_controller.hpp"
 #include "atgames_controller.hpp"
+#include "keyboard_controller.hpp"
+#include "virtual_controller.hpp"
 
 namespace ams::controller {
 
     const constexpr char* pro_controller_name = "Pro Controller";
     const constexpr char* wii_controller_prefix = "Nintendo RVL";
 
+    // Values are persisted by the identity cache, bump IdentityCacheVersion if they change
     enum ControllerType {
         ControllerType_Switch,
         ControllerType_Wii,
@@ -67,22 +73,38 @@ namespace ams::controller {
         ControllerType_LanShen,
         ControllerType_AtGames,
         ControllerType_Unknown,
+        ControllerType_Keyboard,
+        ControllerType_Virtual,
     };
 
-    class UnknownController : public EmulatedSwitchController{
+    class UnknownController : public EmulatedSwitchControllerImpl<UnknownController> {
         public:
             UnknownController(const bluetooth::Address *address) 
-            : EmulatedSwitchController(address) { 
+            : EmulatedSwitchControllerImpl(address) { 
                 m_colours.buttons = {0xff, 0x00, 0x00};
             };
+
+            // Input from unrecognised devices isn't translated, a neutral state is reported instead
+            void UpdateControllerState(const bluetooth::HidReport *report) { };
     };
 
+    extern template class EmulatedSwitchControllerImpl<UnknownController>;
+
     ControllerType Identify(const bluetooth::DevicesSettings *device);
     bool IsAllowedDeviceClass(const bluetooth::DeviceClass *cod);
+    bool IsPeripheralDeviceClass(const bluetooth::DeviceClass *cod);
     bool IsOfficialSwitchControllerName(const std::string& name);
     
     void AttachHandler(const bluetooth::Address *address);
     void RemoveHandler(const bluetooth::Address *address);
     SwitchController *LocateHandler(const bluetooth::Address *address);
+    void SetTsi(const bluetooth::Address *address, uint8_t tsi);
+
+    Result AttachVirtualHandler(bluetooth::Address *address, Handle *out_handle);
+    Result RemoveVirtualHandler(const bluetooth::Address *address);
+
+    void ApplyConfigUpdates(void);
+    bool ServicePacedControllers(TimeSpan *timeout);
+    size_t GetControllerStatistics(ControllerStatistics *stats, size_t max_count);
 
 }
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_state_feed.hpp"
+#include <mutex>
+#include <cstring>
+
+namespace ams::controller {
+
+    namespace {
+
+        constexpr size_t state_feed_sharedmem_size = 0x1000;
+
+        SharedMemory g_state_feed_shmem;
+        ControllerStateFeed *g_state_feed;
+
+        os::Mutex g_slot_lock(false);
+
+        // Slot contents excluding the sequence counter, staged locally so they can be copied into the slot in one go
+        struct ControllerStateData {
+            bluetooth::Address address;
+            uint8_t type;
+            uint8_t flags;
+            uint8_t battery;
+            SwitchButtonData buttons;
+            SwitchAnalogStick left_stick;
+            SwitchAnalogStick right_stick;
+            Switch6AxisData motion[3];
+            uint8_t timer;
+            uint8_t reserved[5];
+        } __attribute__ ((__packed__));
+        static_assert(sizeof(ControllerStateData) == sizeof(ControllerStateSlot) - offsetof(ControllerStateSlot, address));
+
+        void WriteSlot(ControllerStateSlot *slot, const ControllerStateData *data) {
+            auto sequence = slot->sequence.load(std::memory_order_relaxed);
+            slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            std::memcpy(&slot->address, data, sizeof(ControllerStateData));
+
+            slot->sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+    }
+
+    Result InitializeStateFeed(void) {
+        R_TRY(shmemCreate(&g_state_feed_shmem, state_feed_sharedmem_size, Perm_Rw, Perm_R));
+        R_TRY(shmemMap(&g_state_feed_shmem));
+
+        // Newly created shared memory is zero filled, so all slots start out disconnected
+        g_state_feed = reinterpret_cast<ControllerStateFeed *>(shmemGetAddr(&g_state_feed_shmem));
+        g_state_feed->version = ControllerStateFeedVersion;
+        g_state_feed->slot_count = MaxControllerStateSlots;
+
+        return ams::ResultSuccess();
+    }
+
+    SharedMemory *GetStateFeedSharedMemory(void) {
+        if (!g_state_feed)
+            return nullptr;
+
+        return &g_state_feed_shmem;
+    }
+
+    ControllerStateSlot *AcquireStateSlot(const bluetooth::Address *address, uint8_t type) {
+        if (!g_state_feed)
+            return nullptr;
+
+        std::scoped_lock lk(g_slot_lock);
+
+        for (auto& slot : g_state_feed->slots) {
+            if (slot.flags & ControllerStateFlag_Connected)
+                continue;
+
+            ControllerStateData data = {};
+            data.address = *address;
+            data.type = type;
+            data.flags = ControllerStateFlag_Connected;
+            data.left_stick.SetData(STICK_ZERO, STICK_ZERO);
+            data.right_stick.SetData(STICK_ZERO, STICK_ZERO);
+            WriteSlot(&slot, &data);
+
+            return &slot;
+        }
+
+        return nullptr;
+    }
+
+    void ReleaseStateSlot(ControllerStateSlot *slot) {
+        if (!slot)
+            return;
+
+        std::scoped_lock lk(g_slot_lock);
+
+        ControllerStateData data = {};
+        WriteSlot(slot, &data);
+    }
+
+    void PublishState(ControllerStateSlot *slot, const SwitchInputReport0x30 *report) {
+        ControllerStateData data;
+        data.address     = slot->address;
+        data.type        = slot->type;
+        data.flags       = ControllerStateFlag_Connected;
+        data.battery     = report->battery;
+        data.buttons     = report->buttons;
+        data.left_stick  = report->left_stick;
+        data.right_stick = report->right_stick;
+        std::memcpy(data.motion, report->motion, sizeof(data.motion));
+        data.timer       = report->timer;
+        std::memset(data.reserved, 0, sizeof(data.reserved));
+
+        WriteSlot(slot, &data);
+    }
+
+}
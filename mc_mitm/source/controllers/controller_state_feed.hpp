@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include <atomic>
+#include "switch_controller.hpp"
+
+namespace ams::controller {
+
+    constexpr u32 ControllerStateFeedVersion = 1;
+    constexpr size_t MaxControllerStateSlots = 8;
+
+    enum ControllerStateFlag : uint8_t {
+        ControllerStateFlag_Connected = BIT(0),
+    };
+
+    // Latest translated state of a single controller. Readers must retry while the sequence is odd or changes across the read
+    struct alignas(64) ControllerStateSlot {
+        std::atomic<uint32_t> sequence;
+        bluetooth::Address address;
+        uint8_t type;
+        uint8_t flags;
+        uint8_t battery;
+        SwitchButtonData buttons;
+        SwitchAnalogStick left_stick;
+        SwitchAnalogStick right_stick;
+        Switch6AxisData motion[3];
+        uint8_t timer;
+        uint8_t reserved[5];
+    };
+    static_assert(sizeof(ControllerStateSlot) == 64);
+
+    // Layout of the read-only shared memory returned by the GetControllerStateFeed extension
+    struct ControllerStateFeed {
+        uint32_t version;
+        uint32_t slot_count;
+        uint8_t reserved[56];
+        ControllerStateSlot slots[MaxControllerStateSlots];
+    };
+    static_assert(sizeof(ControllerStateFeed) <= 0x1000);
+
+    Result InitializeStateFeed(void);
+    SharedMemory *GetStateFeedSharedMemory(void);
+
+    ControllerStateSlot *AcquireStateSlot(const bluetooth::Address *address, uint8_t type);
+    void ReleaseStateSlot(ControllerStateSlot *slot);
+    void PublishState(ControllerStateSlot *slot, const SwitchInputReport0x30 *report);
+
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "controller_stats.hpp"
+
+namespace ams::controller {
+
+    ControllerStats::ControllerStats(void)
+    : m_untracked_input_reports(0)
+    , m_untracked_output_reports(0)
+    , m_last_input_tick(0)
+    , m_translation_ticks_total(0)
+    , m_translation_ticks_max(0)
+    , m_reports_sent(0)
+    , m_rumble_suppressed(0)
+    , m_buffer_full_drops(0)
+    , m_buffer_occupancy_max(0) {
+        for (size_t i = 0; i < MaxTrackedReportIds; ++i) {
+            m_input_reports[i].id = UntrackedReportId;
+            m_input_reports[i].count = 0;
+            m_output_reports[i].id = UntrackedReportId;
+            m_output_reports[i].count = 0;
+        }
+
+        for (auto& bucket : m_inter_arrival_ms)
+            bucket = 0;
+    }
+
+    void ControllerStats::CountReport(IdCounter *counters, std::atomic<uint32_t> *untracked, uint8_t id) {
+        for (size_t i = 0; i < MaxTrackedReportIds; ++i) {
+            auto slot_id = counters[i].id.load(std::memory_order_relaxed);
+            if (slot_id == id) {
+                counters[i].count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            // Claim the first free slot for a report id we haven't seen before
+            if (slot_id == UntrackedReportId) {
+                counters[i].count.store(1, std::memory_order_relaxed);
+                counters[i].id.store(id, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        untracked->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ControllerStats::RecordInputReport(uint8_t id, os::Tick now) {
+        CountReport(m_input_reports, &m_untracked_input_reports, id);
+
+        if (m_last_input_tick.GetInt64Value() != 0) {
+            auto ms = os::ConvertToTimeSpan(now - m_last_input_tick).GetMilliSeconds();
+
+            // Bucket by power of two
+            size_t bucket = 0;
+            while ((ms > 0) && (bucket < NumInterArrivalBuckets - 1)) {
+                ms >>= 1;
+                ++bucket;
+            }
+
+            m_inter_arrival_ms[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        m_last_input_tick = now;
+    }
+
+    void ControllerStats::RecordOutputReport(uint8_t id) {
+        CountReport(m_output_reports, &m_untracked_output_reports, id);
+    }
+
+    void ControllerStats::RecordTranslationTime(os::Tick elapsed) {
+        uint64_t ticks = elapsed.GetInt64Value();
+        m_translation_ticks_total.fetch_add(ticks, std::memory_order_relaxed);
+
+        if (ticks > m_translation_ticks_max.load(std::memory_order_relaxed))
+            m_translation_ticks_max.store(ticks, std::memory_order_relaxed);
+    }
+
+    void ControllerStats::RecordBufferOccupancy(uint32_t bytes) {
+        if (bytes > m_buffer_occupancy_max.load(std::memory_order_relaxed))
+            m_buffer_occupancy_max.store(bytes, std::memory_order_relaxed);
+    }
+
+    void ControllerStats::GetSnapshot(ControllerStatistics *out) const {
+        for (size_t i = 0; i < MaxTrackedReportIds; ++i) {
+            out->input_reports[i].id = m_input_reports[i].id.load(std::memory_order_relaxed);
+            out->input_reports[i].reserved = 0;
+            out->input_reports[i].count = m_input_reports[i].count.load(std::memory_order_relaxed);
+            out->output_reports[i].id = m_output_reports[i].id.load(std::memory_order_relaxed);
+            out->output_reports[i].reserved = 0;
+            out->output_reports[i].count = m_output_reports[i].count.load(std::memory_order_relaxed);
+        }
+
+        out->untracked_input_reports = m_untracked_input_reports.load(std::memory_order_relaxed);
+        out->untracked_output_reports = m_untracked_output_reports.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < NumInterArrivalBuckets; ++i)
+            out->inter_arrival_ms[i] = m_inter_arrival_ms[i].load(std::memory_order_relaxed);
+
+        out->translation_time_total_us = os::ConvertToTimeSpan(os::Tick(m_translation_ticks_total.load(std::memory_order_relaxed))).GetMicroSeconds();
+        out->translation_time_max_us = os::ConvertToTimeSpan(os::Tick(m_translation_ticks_max.load(std::memory_order_relaxed))).GetMicroSeconds();
+        out->reports_sent = m_reports_sent.load(std::memory_order_relaxed);
+        out->rumble_suppressed = m_rumble_suppressed.load(std::memory_order_relaxed);
+        out->buffer_full_drops = m_buffer_full_drops.load(std::memory_order_relaxed);
+        out->buffer_occupancy_max = m_buffer_occupancy_max.load(std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include <atomic>
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::controller {
+
+    constexpr size_t MaxTrackedReportIds = 8;
+    constexpr size_t NumInterArrivalBuckets = 8;
+    constexpr uint16_t UntrackedReportId = 0xffff;
+
+    struct ReportIdCount {
+        uint16_t id;
+        uint16_t reserved;
+        uint32_t count;
+    };
+
+    // Snapshot of the statistics for a single controller, as returned by the GetControllerStatistics extension
+    struct ControllerStatistics {
+        bluetooth::Address address;
+        uint16_t reserved;
+        ReportIdCount input_reports[MaxTrackedReportIds];     // Reports received from the controller
+        ReportIdCount output_reports[MaxTrackedReportIds];    // Reports received from the console
+        uint32_t untracked_input_reports;
+        uint32_t untracked_output_reports;
+        uint32_t inter_arrival_ms[NumInterArrivalBuckets];    // Histogram with buckets of <1, <2, <4, <8, <16, <32, <64, >=64ms
+        uint64_t translation_time_total_us;
+        uint32_t translation_time_max_us;
+        uint32_t reports_sent;
+        uint32_t rumble_suppressed;
+        uint32_t buffer_full_drops;
+        uint32_t buffer_occupancy_max;                        // Most bytes seen pending in the fake report buffer when a report was written
+        uint32_t reserved2;
+    };
+
+    // Counters are updated with relaxed atomics. Each direction has a single writer (the report thread for input, the ipc server thread for output)
+    class ControllerStats {
+
+        public:
+            ControllerStats(void);
+
+            void RecordInputReport(uint8_t id, os::Tick now);
+            void RecordOutputReport(uint8_t id);
+            void RecordTranslationTime(os::Tick elapsed);
+            void RecordReportSent(void) { m_reports_sent.fetch_add(1, std::memory_order_relaxed); }
+            void RecordRumbleSuppressed(void) { m_rumble_suppressed.fetch_add(1, std::memory_order_relaxed); }
+            void RecordBufferFullDrop(void) { m_buffer_full_drops.fetch_add(1, std::memory_order_relaxed); }
+            void RecordBufferOccupancy(uint32_t bytes);
+
+            void GetSnapshot(ControllerStatistics *out) const;
+
+        private:
+            struct IdCounter {
+                std::atomic<uint16_t> id;
+                std::atomic<uint32_t> count;
+            };
+
+            static void CountReport(IdCounter *counters, std::atomic<uint32_t> *untracked, uint8_t id);
+
+            IdCounter m_input_reports[MaxTrackedReportIds];
+            IdCounter m_output_reports[MaxTrackedReportIds];
+            std::atomic<uint32_t> m_untracked_input_reports;
+            std::atomic<uint32_t> m_untracked_output_reports;
+
+            os::Tick m_last_input_tick;
+            std::atomic<uint32_t> m_inter_arrival_ms[NumInterArrivalBuckets];
+
+            std::atomic<uint64_t> m_translation_ticks_total;
+            std::atomic<uint64_t> m_translation_ticks_max;
+
+            std::atomic<uint32_t> m_reports_sent;
+            std::atomic<uint32_t> m_rumble_suppressed;
+            std::atomic<uint32_t> m_buffer_full_drops;
+            std::atomic<uint32_t> m_buffer_occupancy_max;
+    };
+
+}
@@ -14,9 +14,39 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "controller_utils.hpp"
+#include <array>
+#include <cstring>
 
 namespace ams::controller {
 
+    namespace {
+
+        using Crc32Tables = std::array<std::array<uint32_t, 0x100>, 8>;
+
+        // Tables for slicing-by-8 on the reflected crc32 polynomial. Table n advances a byte n positions further through the data
+        constexpr Crc32Tables GenerateCrc32Tables(void) {
+            Crc32Tables tables = {};
+
+            for (uint32_t i = 0; i < 0x100; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+
+                tables[0][i] = crc;
+            }
+
+            for (size_t n = 1; n < tables.size(); ++n) {
+                for (uint32_t i = 0; i < 0x100; ++i)
+                    tables[n][i] = (tables[n - 1][i] >> 8) ^ tables[0][tables[n - 1][i] & 0xff];
+            }
+
+            return tables;
+        }
+
+        constexpr Crc32Tables crc32_tables = GenerateCrc32Tables();
+
+    }
+
     uint8_t convert_battery_100(uint8_t level) {
         return level ? (((level - 1) / 25) + 1) << 1 : 0;
     }
@@ -25,4 +55,26 @@ namespace ams::controller {
         return level ? ((level / 64) + 1) << 1 : 0;
     }
 
+    uint32_t crc32_update(uint32_t state, const void *data, size_t size) {
+        auto p = reinterpret_cast<const uint8_t *>(data);
+
+        while (size >= 8) {
+            uint32_t lo, hi;
+            std::memcpy(&lo, p, sizeof(lo));
+            std::memcpy(&hi, p + 4, sizeof(hi));
+            lo ^= state;
+
+            state = crc32_tables[7][lo & 0xff] ^ crc32_tables[6][(lo >> 8) & 0xff] ^ crc32_tables[5][(lo >> 16) & 0xff] ^ crc32_tables[4][lo >> 24] ^
+                    crc32_tables[3][hi & 0xff] ^ crc32_tables[2][(hi >> 8) & 0xff] ^ crc32_tables[1][(hi >> 16) & 0xff] ^ crc32_tables[0][hi >> 24];
+
+            p += 8;
+            size -= 8;
+        }
+
+        while (size--)
+            state = (state >> 8) ^ crc32_tables[0][(state ^ *p++) & 0xff];
+
+        return state;
+    }
+
 }
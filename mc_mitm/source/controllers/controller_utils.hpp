@@ -20,5 +20,9 @@ namespace ams::controller {
 
     uint8_t convert_battery_100(uint8_t level);
     uint8_t convert_battery_255(uint8_t level);
+
+    // Incremental form of crc32Calculate. Start from crc32_initial_state, and invert the final state to get the crc
+    constexpr uint32_t crc32_initial_state = 0xffffffff;
+    uint32_t crc32_update(uint32_t state, const void *data, size_t size);
     
 }
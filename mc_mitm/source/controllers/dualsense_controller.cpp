@@ -16,6 +16,7 @@
 #include "dualsense_controller.hpp"
 #include "../mcmitm_config.hpp"
 #include <stratosphere.hpp>
+#include <algorithm>
 
 namespace ams::controller {
 
@@ -54,7 +55,13 @@ namespace ams::controller {
 
     Result DualsenseController::Initialize(void) {
         R_TRY(EmulatedSwitchController::Initialize());
-        R_TRY(this->PushRumbleLedState());
+
+        const uint8_t header[] = {0xa2, 0x31, 0x02, 0x03, 0x14};
+        m_output_report.SetHeader(header, sizeof(header));
+        m_output_report.Set(41, 0x02);
+        m_output_report.Set(44, 0x02);
+
+        R_TRY(this->PushRumbleLedState(false));
 
         return ams::ResultSuccess();
     }
@@ -62,13 +69,13 @@ namespace ams::controller {
     Result DualsenseController::SetVibration(const SwitchRumbleData *rumble_data) {
         m_rumble_state.amp_motor_left  = static_cast<uint8_t>(255 * rumble_data->low_band_amp);
         m_rumble_state.amp_motor_right = static_cast<uint8_t>(255 * rumble_data->high_band_amp);
-        return this->PushRumbleLedState();
+        return this->PushRumbleLedState(true);
     }
 
     Result DualsenseController::CancelVibration(void) {
         m_rumble_state.amp_motor_left = 0;
         m_rumble_state.amp_motor_right = 0;
-        return this->PushRumbleLedState();
+        return this->PushRumbleLedState(true);
     }
 
     Result DualsenseController::SetPlayerLed(uint8_t led_mask) {
@@ -79,10 +86,19 @@ namespace ams::controller {
         return this->SetLightbarColour(colour);
     }
 
+    void DualsenseController::SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile) {
+        EmulatedSwitchController::SetProfile(config, profile);
+
+        m_disable_leds = config->misc.disable_sony_leds;
+
+        // The Dualsense has no report rate setting over bluetooth, so pace the reports we emit to the requested interval instead
+        if (profile && profile->report_interval_ms)
+            m_pacing_interval = std::max(m_pacing_interval, os::ConvertToTick(TimeSpan::FromMilliSeconds(profile->report_interval_ms)));
+    }
+
     Result DualsenseController::SetLightbarColour(RGBColour colour) {
-        auto config = mitm::GetGlobalConfig();
-        m_led_colour = config->misc.disable_sony_leds ? led_disable : colour;
-        return this->PushRumbleLedState();
+        m_led_colour = m_disable_leds ? led_disable : colour;
+        return this->PushRumbleLedState(false);
     }
 
     void DualsenseController::UpdateControllerState(const bluetooth::HidReport *report) {
@@ -173,20 +189,31 @@ namespace ams::controller {
         m_buttons.home    = buttons->ps;
     }
 
-    Result DualsenseController::PushRumbleLedState(void) {
-        DualsenseOutputReport0x31 report = {0xa2, 0x31, 0x02, 0x03, 0x14, m_rumble_state.amp_motor_right, m_rumble_state.amp_motor_left};
-        report.data[41] = 0x02;
-        report.data[44] = 0x02;
-        report.data[46] = m_led_flags;
-        report.data[47] = m_led_colour.r;
-        report.data[48] = m_led_colour.g;
-        report.data[49] = m_led_colour.b;
-        report.crc = crc32Calculate(report.data, sizeof(report.data));
+    Result DualsenseController::PushRumbleLedState(bool rumble) {
+        m_output_report.Set(5, m_rumble_state.amp_motor_right);
+        m_output_report.Set(6, m_rumble_state.amp_motor_left);
+        m_output_report.Set(46, m_led_flags);
+        m_output_report.Set(47, m_led_colour.r);
+        m_output_report.Set(48, m_led_colour.g);
+        m_output_report.Set(49, m_led_colour.b);
 
-        s_output_report.size = sizeof(report) - 1;
-        std::memcpy(s_output_report.data, &report.data[1], s_output_report.size);
+        // Nothing changed since the last report, don't waste bandwidth resending it. Only rumble pushes count towards the suppressed rumble statistic
+        if (!m_output_report.IsDirty()) {
+            if (rumble)
+                m_stats.RecordRumbleSuppressed();
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+            return ams::ResultSuccess();
+        }
+
+        std::scoped_lock lk(s_output_report_lock);
+
+        m_output_report.Build(&s_output_report);
+        R_TRY(this->SendHidReport(&s_output_report));
+        m_output_report.MarkSent();
+
+        return ams::ResultSuccess();
     }
 
+    template class EmulatedSwitchControllerImpl<DualsenseController>;
+
 }
@@ -15,6 +15,7 @@
  */
 #pragma once
 #include "emulated_switch_controller.hpp"
+#include "sony_output_report.hpp"
 
 namespace ams::controller {
 
@@ -107,7 +108,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class DualsenseController : public EmulatedSwitchController {
+    class DualsenseController : public EmulatedSwitchControllerImpl<DualsenseController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -115,11 +116,14 @@ namespace ams::controller {
             };  
 
             DualsenseController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address)
+                : EmulatedSwitchControllerImpl(address)
                 , m_led_flags(0)
+                , m_disable_leds(false)
                 , m_led_colour({0, 0, 0})
                 , m_rumble_state({0, 0}) { };
 
+            void SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile);
+
             Result Initialize(void);
             Result SetVibration(const SwitchRumbleData *rumble_data);
             Result CancelVibration(void);
@@ -134,10 +138,14 @@ namespace ams::controller {
 
             void MapButtons(const DualsenseButtonData *buttons);
 
-            Result PushRumbleLedState(void);
+            Result PushRumbleLedState(bool rumble);
 
             uint8_t m_led_flags;
+            bool m_disable_leds;
             RGBColour m_led_colour;
             DualsenseRumbleData m_rumble_state; 
+            SonyOutputReport<DualsenseOutputReport0x31> m_output_report;
     };
+
+    extern template class EmulatedSwitchControllerImpl<DualsenseController>;
 }
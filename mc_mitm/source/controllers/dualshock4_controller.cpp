@@ -18,6 +18,7 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include <cstring>
+#include <algorithm>
 
 namespace ams::controller {
 
@@ -44,7 +45,7 @@ namespace ams::controller {
 
     Result Dualshock4Controller::Initialize(void) {
         R_TRY(EmulatedSwitchController::Initialize());
-        R_TRY(this->PushRumbleLedState());
+        R_TRY(this->PushRumbleLedState(false));
 
         return ams::ResultSuccess();
     }
@@ -52,13 +53,13 @@ namespace ams::controller {
     Result Dualshock4Controller::SetVibration(const SwitchRumbleData *rumble_data) {
         m_rumble_state.amp_motor_left  = static_cast<uint8_t>(255 * rumble_data->low_band_amp);
         m_rumble_state.amp_motor_right = static_cast<uint8_t>(255 * rumble_data->high_band_amp);
-        return this->PushRumbleLedState();
+        return this->PushRumbleLedState(true);
     }
 
     Result Dualshock4Controller::CancelVibration(void) {
         m_rumble_state.amp_motor_left = 0;
         m_rumble_state.amp_motor_right = 0;
-        return this->PushRumbleLedState();
+        return this->PushRumbleLedState(true);
     }
 
     Result Dualshock4Controller::SetPlayerLed(uint8_t led_mask) {
@@ -68,10 +69,19 @@ namespace ams::controller {
         return this->SetLightbarColour(colour);
     }
 
+    void Dualshock4Controller::SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile) {
+        EmulatedSwitchController::SetProfile(config, profile);
+
+        m_disable_leds = config->misc.disable_sony_leds;
+
+        // The rate is given in milliseconds between reports, up to 16. A change is sent to the controller with the next output report
+        auto interval_ms = (profile && profile->report_interval_ms) ? profile->report_interval_ms : switch_report_interval_ms;
+        m_report_rate = static_cast<Dualshock4ReportRate>(std::min<uint32_t>(interval_ms, Dualshock4ReportRate_62Hz));
+    }
+
     Result Dualshock4Controller::SetLightbarColour(RGBColour colour) {
-        auto config = mitm::GetGlobalConfig();
-        m_led_colour = config->misc.disable_sony_leds ? led_disable : colour;
-        return this->PushRumbleLedState();
+        m_led_colour = m_disable_leds ? led_disable : colour;
+        return this->PushRumbleLedState(false);
     }
 
     void Dualshock4Controller::UpdateControllerState(const bluetooth::HidReport *report) {
@@ -162,17 +172,33 @@ namespace ams::controller {
         m_buttons.home    = buttons->ps;
     }
 
-    Result Dualshock4Controller::PushRumbleLedState(void) {
-        Dualshock4OutputReport0x11 report = {0xa2, 0x11, static_cast<uint8_t>(0xc0 | (m_report_rate & 0xff)), 0x20, 0xf3, 0x04, 0x00,
-            m_rumble_state.amp_motor_right, m_rumble_state.amp_motor_left,
-            m_led_colour.r, m_led_colour.g, m_led_colour.b
-        };
-        report.crc = crc32Calculate(report.data, sizeof(report.data));
+    Result Dualshock4Controller::PushRumbleLedState(bool rumble) {
+        const uint8_t header[] = {0xa2, 0x11, static_cast<uint8_t>(0xc0 | (m_report_rate & 0xff)), 0x20, 0xf3, 0x04, 0x00};
+        m_output_report.SetHeader(header, sizeof(header));
+
+        m_output_report.Set(7, m_rumble_state.amp_motor_right);
+        m_output_report.Set(8, m_rumble_state.amp_motor_left);
+        m_output_report.Set(9, m_led_colour.r);
+        m_output_report.Set(10, m_led_colour.g);
+        m_output_report.Set(11, m_led_colour.b);
 
-        s_output_report.size = sizeof(report) - 1;
-        std::memcpy(s_output_report.data, &report.data[1], s_output_report.size);
+        // Nothing changed since the last report, don't waste bandwidth resending it. Only rumble pushes count towards the suppressed rumble statistic
+        if (!m_output_report.IsDirty()) {
+            if (rumble)
+                m_stats.RecordRumbleSuppressed();
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+            return ams::ResultSuccess();
+        }
+
+        std::scoped_lock lk(s_output_report_lock);
+
+        m_output_report.Build(&s_output_report);
+        R_TRY(this->SendHidReport(&s_output_report));
+        m_output_report.MarkSent();
+
+        return ams::ResultSuccess();
     }
 
+    template class EmulatedSwitchControllerImpl<Dualshock4Controller>;
+
 }
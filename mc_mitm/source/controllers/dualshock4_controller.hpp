@@ -15,6 +15,7 @@
  */
 #pragma once
 #include "emulated_switch_controller.hpp"
+#include "sony_output_report.hpp"
 
 namespace ams::controller {
 
@@ -139,7 +140,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class Dualshock4Controller : public EmulatedSwitchController {
+    class Dualshock4Controller : public EmulatedSwitchControllerImpl<Dualshock4Controller> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -150,11 +151,14 @@ namespace ams::controller {
             };
 
             Dualshock4Controller(const bluetooth::Address *address)
-                : EmulatedSwitchController(address)
-                , m_report_rate(Dualshock4ReportRate_125Hz)
+                : EmulatedSwitchControllerImpl(address)
+                , m_report_rate(Dualshock4ReportRate_66Hz)
+                , m_disable_leds(false)
                 , m_led_colour({0, 0, 0})
                 , m_rumble_state({0, 0}) { };
 
+            void SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile);
+
             Result Initialize(void);
             Result SetVibration(const SwitchRumbleData *rumble_data);
             Result CancelVibration(void);
@@ -169,11 +173,15 @@ namespace ams::controller {
 
             void MapButtons(const Dualshock4ButtonData *buttons);
             
-            Result PushRumbleLedState(void);
+            Result PushRumbleLedState(bool rumble);
 
             Dualshock4ReportRate m_report_rate;
+            bool m_disable_leds;
             RGBColour m_led_colour; 
             Dualshock4RumbleData m_rumble_state; 
+            SonyOutputReport<Dualshock4OutputReport0x11> m_output_report;
     };
 
+    extern template class EmulatedSwitchControllerImpl<Dualshock4Controller>;
+
 }
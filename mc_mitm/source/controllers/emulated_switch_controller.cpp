@@ -14,13 +14,20 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "emulated_switch_controller.hpp"
+#include "load_governor.hpp"
 #include "../mcmitm_config.hpp"
 #include <memory>
+#include <mutex>
+#include <algorithm>
+#include <iterator>
 
 namespace ams::controller {
 
     namespace {
 
+        // Minimum spacing between rumble and led updates when the load governor has reduced fidelity
+        constexpr auto reduced_output_interval = TimeSpan::FromMilliSeconds(30);
+
         // Factory calibration data representing analog stick ranges that span the entire 12-bit data type in x and y
         SwitchAnalogStickFactoryCalibration lstick_factory_calib = {0xff, 0xf7, 0x7f, 0x00, 0x08, 0x80, 0x00, 0x08, 0x80};
         SwitchAnalogStickFactoryCalibration rstick_factory_calib = {0x00, 0x08, 0x80, 0x00, 0x08, 0x80, 0xff, 0xf7, 0x7f};
@@ -70,6 +77,10 @@ namespace ams::controller {
 
         };
 
+        // Report intervals used for each tsi index when a profile enables tsi pacing. The console only passes the index, so these
+        // spread the default interval of official controllers up to double it across the range rather than matching the radio timings
+        constexpr uint8_t tsi_report_intervals_ms[] = {15, 15, 15, 18, 18, 21, 21, 24, 24, 27, 30};
+
         inline void DecodeRumbleValues(const uint8_t enc[], SwitchRumbleData *dec) {
             uint8_t hi_freq_ind = 0x20 + (enc[0] >> 2) + ((enc[1] & 0x01) * 0x40) - 1;
             uint8_t hi_amp_ind  = (enc[1] & 0xfe) >> 1;
@@ -87,17 +98,25 @@ namespace ams::controller {
     EmulatedSwitchController::EmulatedSwitchController(const bluetooth::Address *address) 
     : SwitchController(address)
     , m_charging(false)
-    , m_battery(BATTERY_MAX) { 
+    , m_battery(BATTERY_MAX)
+    , m_enable_rumble(true)
+    , m_pacing_interval(0)
+    , m_tsi_pacing(false)
+    , m_tsi_interval(0)
+    , m_next_report_tick(0)
+    , m_pacing_buttons(0)
+    , m_report_pending(false)
+    , m_next_output_tick(0)
+    , m_pending_rumble({})
+    , m_rumble_pending(false)
+    , m_pending_led_mask(0)
+    , m_led_pending(false) { 
         this->ClearControllerState();
 
         m_colours.body       = {0x32, 0x32, 0x32};
         m_colours.buttons    = {0xe6, 0xe6, 0xe6};
         m_colours.left_grip  = {0x46, 0x46, 0x46};
         m_colours.right_grip = {0x46, 0x46, 0x46};
-
-        auto config = mitm::GetGlobalConfig();
-
-        m_enable_rumble = config->general.enable_rumble;
     };
 
     void EmulatedSwitchController::ClearControllerState(void) {
@@ -107,24 +126,120 @@ namespace ams::controller {
         std::memset(&m_motion_data, 0, sizeof(m_motion_data));
     }
 
-    Result EmulatedSwitchController::HandleIncomingReport(const bluetooth::HidReport *report) {
-        this->UpdateControllerState(report);
+    void EmulatedSwitchController::SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile) {
+        SwitchController::SetProfile(config, profile);
+
+        m_enable_rumble = config->general.enable_rumble;
+
+        auto interval_ms = profile ? profile->pacing_interval_ms : 0;
+        m_pacing_interval = os::ConvertToTick(TimeSpan::FromMilliSeconds(interval_ms));
+        m_tsi_pacing = profile && profile->tsi_pacing;
+
+        RequestPacingService();
+    }
+
+    void EmulatedSwitchController::SetTsi(uint8_t tsi) {
+        // Pace reports to the requested slot interval so we don't send more than the console asked for. 0xff restores the default
+        auto interval = tsi < std::size(tsi_report_intervals_ms) ? os::ConvertToTick(TimeSpan::FromMilliSeconds(tsi_report_intervals_ms[tsi])) : os::Tick(0);
+        m_tsi_interval.store(interval.GetInt64Value(), std::memory_order_relaxed);
+
+        if (m_tsi_pacing)
+            RequestPacingService();
+    }
+
+    bool EmulatedSwitchController::ServicePacing(os::Tick now, os::Tick *deadline) {
+        os::Tick output_deadline;
+        bool output_pending = this->ServiceDeferredOutput(now, &output_deadline);
+
+        // Without pacing, only a report held back by the load governor needs flushing
+        bool paced = (this->GetPacingInterval().GetInt64Value() != 0) || m_report_pending;
+        if (paced) {
+            // Resend the current state if the device hasn't reported since the last deadline
+            if (now >= m_next_report_tick)
+                this->WriteInputReport(now);
+
+            paced = (this->GetPacingInterval().GetInt64Value() != 0) || m_report_pending;
+        }
 
-        // Prepare Switch report
-        s_input_report.size = sizeof(SwitchInputReport0x30) + 1;
-        auto switch_report = reinterpret_cast<SwitchReportData *>(s_input_report.data);
-        switch_report->id = 0x30;
-        switch_report->input0x30.conn_info      = 0;
-        switch_report->input0x30.battery        = m_battery | m_charging;
-        switch_report->input0x30.buttons        = m_buttons;
-        switch_report->input0x30.left_stick     = m_left_stick;
-        switch_report->input0x30.right_stick    = m_right_stick;
-        std::memcpy(&switch_report->input0x30.motion, &m_motion_data, sizeof(m_motion_data));
+        if (!paced && !output_pending)
+            return false;
 
-        this->ApplyButtonCombos(&switch_report->input0x30.buttons);
+        if (!paced)
+            *deadline = output_deadline;
+        else if (!output_pending)
+            *deadline = m_next_report_tick;
+        else
+            *deadline = std::min(m_next_report_tick, output_deadline);
 
-        switch_report->input0x30.timer = os::ConvertToTimeSpan(os::GetSystemTick()).GetMilliSeconds() & 0xff;
-        return bluetooth::hid::report::WriteHidReportBuffer(&m_address, &s_input_report);
+        return true;
+    }
+
+    bool EmulatedSwitchController::ServiceDeferredOutput(os::Tick now, os::Tick *deadline) {
+        std::scoped_lock lk(m_output_lock);
+
+        if (!m_rumble_pending && !m_led_pending)
+            return false;
+
+        if (now < m_next_output_tick) {
+            *deadline = m_next_output_tick;
+            return true;
+        }
+
+        m_next_output_tick = now + os::ConvertToTick(reduced_output_interval);
+
+        if (m_rumble_pending) {
+            m_rumble_pending = false;
+            this->SetVibration(&m_pending_rumble);
+        }
+
+        if (m_led_pending) {
+            m_led_pending = false;
+            this->SetPlayerLed(m_pending_led_mask);
+        }
+
+        return false;
+    }
+
+    Result EmulatedSwitchController::ForwardInputReport(void) {
+        auto now = os::GetSystemTick();
+        if ((this->GetPacingInterval().GetInt64Value() == 0) && (GetLoadLevel() == LoadLevel_Full))
+            return this->WriteInputReport(now);
+
+        // Hold on to any presses until the next report is due so short taps aren't lost
+        m_pacing_buttons |= ButtonDataToMask(&m_buttons);
+        if (now >= m_next_report_tick)
+            return this->WriteInputReport(now);
+
+        if (!m_report_pending) {
+            m_report_pending = true;
+            RequestPacingService();
+        }
+
+        return ams::ResultSuccess();
+    }
+
+    Result EmulatedSwitchController::WriteInputReport(os::Tick now) {
+        uint32_t buttons = ButtonDataToMask(&m_buttons) | m_pacing_buttons;
+        m_pacing_buttons = 0;
+        m_report_pending = false;
+        m_next_report_tick = now + std::max(this->GetPacingInterval(), GetMinimumReportInterval());
+
+        // Build the Switch report directly in the report buffer
+        return this->WriteHidReportBuffer(sizeof(SwitchInputReport0x30) + 1, [&](bluetooth::HidReport *dst) {
+            dst->size = sizeof(SwitchInputReport0x30) + 1;
+            auto switch_report = reinterpret_cast<SwitchReportData *>(dst->data);
+            switch_report->id = 0x30;
+            switch_report->input0x30.conn_info      = 0;
+            switch_report->input0x30.battery        = m_battery | m_charging;
+            MaskToButtonData(this->ApplyButtonProfile(buttons), &switch_report->input0x30.buttons);
+            switch_report->input0x30.left_stick     = m_left_stick;
+            switch_report->input0x30.right_stick    = m_right_stick;
+            switch_report->input0x30.vibrator       = 0;
+            std::memcpy(&switch_report->input0x30.motion, &m_motion_data, sizeof(m_motion_data));
+            switch_report->input0x30.timer = os::ConvertToTimeSpan(now).GetMilliSeconds() & 0xff;
+
+            this->PublishInputReport(switch_report);
+        });
     }
 
     Result EmulatedSwitchController::HandleOutgoingReport(const bluetooth::HidReport *report) {
@@ -194,16 +309,57 @@ namespace ams::controller {
     }
 
     Result EmulatedSwitchController::HandleRumbleReport(const bluetooth::HidReport *report) {
-        R_SUCCEED_IF(!m_enable_rumble);
+        if (!m_enable_rumble) {
+            m_stats.RecordRumbleSuppressed();
+            return ams::ResultSuccess();
+        }
 
         auto report_data = reinterpret_cast<const SwitchReportData *>(report->data);
         
         SwitchRumbleData rumble_data;
         DecodeRumbleValues(report_data->output0x10.left_motor, &rumble_data);
 
+        auto now = os::GetSystemTick();
+        bool stop = (rumble_data.low_band_amp == 0) && (rumble_data.high_band_amp == 0);
+
+        std::scoped_lock lk(m_output_lock);
+
+        // Under heavy load only the latest rumble state is sent, once the next output slot comes round. Stopping the motors always goes through
+        if (!stop && (GetLoadLevel() >= LoadLevel_Reduced) && (now < m_next_output_tick)) {
+            if (m_rumble_pending)
+                m_stats.RecordRumbleSuppressed();
+
+            m_pending_rumble = rumble_data;
+            m_rumble_pending = true;
+            RequestPacingService();
+            return ams::ResultSuccess();
+        }
+
+        m_rumble_pending = false;
+        m_next_output_tick = now + os::ConvertToTick(reduced_output_interval);
+
         return this->SetVibration(&rumble_data);
     }
 
+    Result EmulatedSwitchController::UpdatePlayerLed(uint8_t led_mask) {
+        auto now = os::GetSystemTick();
+
+        std::scoped_lock lk(m_output_lock);
+
+        // Led changes share the output slots with rumble under heavy load, with only the latest mask being sent
+        if ((GetLoadLevel() >= LoadLevel_Reduced) && (now < m_next_output_tick)) {
+            m_pending_led_mask = led_mask;
+            m_led_pending = true;
+            RequestPacingService();
+            return ams::ResultSuccess();
+        }
+
+        m_led_pending = false;
+        m_next_output_tick = now + os::ConvertToTick(reduced_output_interval);
+
+        return this->SetPlayerLed(led_mask);
+    }
+
     Result EmulatedSwitchController::SubCmdRequestDeviceInfo(const bluetooth::HidReport *report) {
         const SwitchSubcommandResponse response = {
             .ack = 0x82, 
@@ -348,7 +504,7 @@ namespace ams::controller {
     Result EmulatedSwitchController::SubCmdSetPlayerLeds(const bluetooth::HidReport *report) {
         const uint8_t *subCmd = &report->data[10];
         uint8_t led_mask = subCmd[1];
-        R_TRY(this->SetPlayerLed(led_mask));
+        R_TRY(this->UpdatePlayerLed(led_mask));
 
         const SwitchSubcommandResponse response = {
             .ack = 0x80,
@@ -399,7 +555,7 @@ namespace ams::controller {
         report_data->input0x21.timer = os::ConvertToTimeSpan(os::GetSystemTick()).GetMilliSeconds() & 0xff;
 
         //Write a fake response into the report buffer
-        return bluetooth::hid::report::WriteHidReportBuffer(&m_address, &s_input_report);
+        return this->WriteHidReportBuffer(&s_input_report);
     }
 
 }
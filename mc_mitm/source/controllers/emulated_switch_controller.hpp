@@ -15,9 +15,14 @@
  */
 #pragma once
 #include "switch_controller.hpp"
+#include <atomic>
+#include <algorithm>
 
 namespace ams::controller {
 
+    // Interval official controllers send input reports at under the console's default tsi
+    constexpr uint32_t switch_report_interval_ms = 15;
+
     inline uint8_t ScaleRumbleAmplitude(float amp, uint8_t lower, uint8_t upper) {
         return amp > 0.0 ? static_cast<uint8_t>(amp * (upper - lower) + lower) : 0;
     }
@@ -28,19 +33,25 @@ namespace ams::controller {
             EmulatedSwitchController(const bluetooth::Address *address);
 
             bool IsOfficialController(void) { return false; };
+
+            void SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile);
+            bool ServicePacing(os::Tick now, os::Tick *deadline);
+            void SetTsi(uint8_t tsi);
             
-            Result HandleIncomingReport(const bluetooth::HidReport *report);
+            // Implemented by EmulatedSwitchControllerImpl, which every emulated controller derives from
+            Result HandleIncomingReport(const bluetooth::HidReport *report) = 0;
             Result HandleOutgoingReport(const bluetooth::HidReport *report);
 
         protected:
             void ClearControllerState(void);
-            virtual void UpdateControllerState(const bluetooth::HidReport *report) {};
             virtual Result SetVibration(const SwitchRumbleData *rumble_data) { return ams::ResultSuccess(); };
             virtual Result CancelVibration(void) { return ams::ResultSuccess(); };
             virtual Result SetPlayerLed(uint8_t led_mask) { return ams::ResultSuccess(); };
 
             Result HandleSubCmdReport(const bluetooth::HidReport *report);
             Result HandleRumbleReport(const bluetooth::HidReport *report);
+            Result UpdatePlayerLed(uint8_t led_mask);
+            bool ServiceDeferredOutput(os::Tick now, os::Tick *deadline);
 
             Result SubCmdRequestDeviceInfo(const bluetooth::HidReport *report);
             Result SubCmdSpiFlashRead(const bluetooth::HidReport *report);
@@ -56,7 +67,17 @@ namespace ams::controller {
             Result SubCmdEnableImu(const bluetooth::HidReport *report);
             Result SubCmdEnableVibration(const bluetooth::HidReport *report);
 
+            // The longer of the profile's pacing interval and, if the profile enables it, the interval requested by the console through SetTsi
+            os::Tick GetPacingInterval(void) const {
+                if (!m_tsi_pacing)
+                    return m_pacing_interval;
+
+                return std::max(m_pacing_interval, os::Tick(m_tsi_interval.load(std::memory_order_relaxed)));
+            }
+
             Result FakeSubCmdResponse(const SwitchSubcommandResponse *response);
+            Result ForwardInputReport(void);
+            Result WriteInputReport(os::Tick now);
 
             bool m_charging;
             uint8_t m_battery;
@@ -68,6 +89,41 @@ namespace ams::controller {
             ProControllerColours m_colours;
             bool m_enable_rumble;
 
+            os::Tick m_pacing_interval;
+            bool m_tsi_pacing;
+            std::atomic<s64> m_tsi_interval;    // Written from the ipc thread
+            os::Tick m_next_report_tick;
+            uint32_t m_pacing_buttons;  // Button presses accumulated since the last paced report
+            bool m_report_pending;      // State held back by decimation that hasn't been reported yet
+
+            // Rumble and led updates held back by the load governor. Written from the ipc thread and flushed from the report thread
+            os::SdkMutex m_output_lock;
+            os::Tick m_next_output_tick;
+            SwitchRumbleData m_pending_rumble;
+            bool m_rumble_pending;
+            uint8_t m_pending_led_mask;
+            bool m_led_pending;
+
+    };
+
+    // Base for controllers that translate HID input reports. The controller's UpdateControllerState is resolved at compile time,
+    // leaving the virtual HandleIncomingReport call made by the report handler as the only indirect call per report
+    template<typename Derived>
+    class EmulatedSwitchControllerImpl : public EmulatedSwitchController {
+
+        public:
+            EmulatedSwitchControllerImpl(const bluetooth::Address *address)
+                : EmulatedSwitchController(address) { };
+
+            Result HandleIncomingReport(const bluetooth::HidReport *report) final;
+
     };
 
+    // Controllers explicitly instantiate this in their own source file so their decoder can be inlined into it
+    template<typename Derived>
+    Result EmulatedSwitchControllerImpl<Derived>::HandleIncomingReport(const bluetooth::HidReport *report) {
+        static_cast<Derived *>(this)->Derived::UpdateControllerState(report);
+        return this->ForwardInputReport();
+    }
+
 }
@@ -83,4 +83,6 @@ namespace ams::controller {
         m_buttons.rstick_press = src->input0xc4.buttons.R3;  
     }
 
+    template class EmulatedSwitchControllerImpl<GamesirController>;
+
 }
@@ -82,7 +82,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class GamesirController : public EmulatedSwitchController {
+    class GamesirController : public EmulatedSwitchControllerImpl<GamesirController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -93,7 +93,7 @@ namespace ams::controller {
             };  
 
             GamesirController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             bool SupportsSetTsiCommand(void) { return false; }
 
@@ -105,4 +105,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<GamesirController>;
+
 }
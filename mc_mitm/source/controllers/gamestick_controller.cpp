@@ -91,4 +91,6 @@ namespace ams::controller {
         m_buttons.rstick_press = src->input0x03.buttons.rstick_press;
     }
 
+    template class EmulatedSwitchControllerImpl<GamestickController>;
+
 }
@@ -82,7 +82,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class GamestickController : public EmulatedSwitchController {
+    class GamestickController : public EmulatedSwitchControllerImpl<GamestickController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -90,7 +90,7 @@ namespace ams::controller {
             };  
 
             GamestickController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -101,4 +101,6 @@ namespace ams::controller {
            
     };
 
+    extern template class EmulatedSwitchControllerImpl<GamestickController>;
+
 }
@@ -82,7 +82,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class GemboxController : public EmulatedSwitchController {
+    class GemboxController : public EmulatedSwitchControllerImpl<GemboxController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -90,7 +90,7 @@ namespace ams::controller {
             };  
 
             GemboxController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -100,4 +100,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<GemboxController>;
+
 }
@@ -18,67 +18,54 @@
 
 namespace ams::controller {
 
-    void ICadeController::UpdateControllerState(const bluetooth::HidReport *report) {
-        auto icade_report = reinterpret_cast<const ICadeReportData *>(&report->data);
+    namespace {
 
-        if (icade_report->id == 0x01) {
+        // Each button sends one key when pressed and another when released
+        constexpr KeyboardKeyBinding icade_bindings[] = {
+            {0x1a, {SwitchButton_DpadUp,    mitm::KeyboardKeyAction_Press}},    // w (joystick up pressed)
+            {0x08, {SwitchButton_DpadUp,    mitm::KeyboardKeyAction_Release}},  // e (joystick up released)
+            {0x07, {SwitchButton_DpadRight, mitm::KeyboardKeyAction_Press}},    // d (joystick right pressed)
+            {0x06, {SwitchButton_DpadRight, mitm::KeyboardKeyAction_Release}},  // c (joystick right released)
+            {0x1b, {SwitchButton_DpadDown,  mitm::KeyboardKeyAction_Press}},    // x (joystick down pressed)
+            {0x1d, {SwitchButton_DpadDown,  mitm::KeyboardKeyAction_Release}},  // z (joystick down released)
+            {0x04, {SwitchButton_DpadLeft,  mitm::KeyboardKeyAction_Press}},    // a (joystick left pressed)
+            {0x14, {SwitchButton_DpadLeft,  mitm::KeyboardKeyAction_Release}},  // q (joystick left released)
+            {0x1c, {SwitchButton_L,         mitm::KeyboardKeyAction_Press}},    // y (button 1 pressed)
+            {0x17, {SwitchButton_L,         mitm::KeyboardKeyAction_Release}},  // t (button 1 released)
+            {0x18, {SwitchButton_X,         mitm::KeyboardKeyAction_Press}},    // u (button 2 pressed)
+            {0x09, {SwitchButton_X,         mitm::KeyboardKeyAction_Release}},  // f (button 2 released)
+            {0x0c, {SwitchButton_A,         mitm::KeyboardKeyAction_Press}},    // i (button 3 pressed)
+            {0x10, {SwitchButton_A,         mitm::KeyboardKeyAction_Release}},  // m (button 3 released)
+            {0x12, {SwitchButton_R,         mitm::KeyboardKeyAction_Press}},    // o (button 4 pressed)
+            {0x0a, {SwitchButton_R,         mitm::KeyboardKeyAction_Release}},  // g (button 4 released)
+            {0x0b, {SwitchButton_ZL,        mitm::KeyboardKeyAction_Press}},    // h (button 5 pressed)
+            {0x15, {SwitchButton_ZL,        mitm::KeyboardKeyAction_Release}},  // r (button 5 released)
+            {0x0d, {SwitchButton_Y,         mitm::KeyboardKeyAction_Press}},    // j (button 6 pressed)
+            {0x11, {SwitchButton_Y,         mitm::KeyboardKeyAction_Release}},  // n (button 6 released)
+            {0x0e, {SwitchButton_B,         mitm::KeyboardKeyAction_Press}},    // k (button 7 pressed)
+            {0x13, {SwitchButton_B,         mitm::KeyboardKeyAction_Release}},  // p (button 7 released)
+            {0x0f, {SwitchButton_ZR,        mitm::KeyboardKeyAction_Press}},    // l (button 8 pressed)
+            {0x19, {SwitchButton_ZR,        mitm::KeyboardKeyAction_Release}},  // v (button 8 released)
+        };
 
-            for (unsigned int i = 0; i < sizeof(icade_report->input0x01.keys); ++i) {
-                
-                switch (icade_report->input0x01.keys[i]) {
-                    case 0x1a: m_buttons.dpad_up    = 1; break; // w (joystick up pressed)
-                    case 0x08: m_buttons.dpad_up    = 0; break; // e (joystick up released)
-                    case 0x07: m_buttons.dpad_right = 1; break; // d (joystick right pressed)
-                    case 0x06: m_buttons.dpad_right = 0; break; // c (joystick right released)
-                    case 0x1b: m_buttons.dpad_down  = 1; break; // x (joystick down pressed)
-                    case 0x1d: m_buttons.dpad_down  = 0; break; // z (joystick down released)
-                    case 0x04: m_buttons.dpad_left  = 1; break; // a (joystick left pressed)
-                    case 0x14: m_buttons.dpad_left  = 0; break; // q (joystick left released)
-                    case 0x1c: m_buttons.L          = 1; break; // y (button 1 pressed)
-                    case 0x17: m_buttons.L          = 0; break; // t (button 1 released)
-                    case 0x18: m_buttons.X          = 1; break; // u (button 2 pressed)
-                    case 0x09: m_buttons.X          = 0; break; // f (button 2 released)
-                    case 0x0c: m_buttons.A          = 1; break; // i (button 3 pressed)
-                    case 0x10: m_buttons.A          = 0; break; // m (button 3 released)
-                    case 0x12: m_buttons.R          = 1; break; // o (button 4 pressed)
-                    case 0x0a: m_buttons.R          = 0; break; // g (button 4 released)
-                    case 0x0b: m_buttons.ZL         = 1; break; // h (button 5 pressed)
-                    case 0x15: m_buttons.ZL         = 0; break; // r (button 5 released)
-                    case 0x0d: m_buttons.Y          = 1; break; // j (button 6 pressed)
-                    case 0x11: m_buttons.Y          = 0; break; // n (button 6 released)
-                    case 0x0e: m_buttons.B          = 1; break; // k (button 7 pressed)
-                    case 0x13: m_buttons.B          = 0; break; // p (button 7 released)
-                    case 0x0f: m_buttons.ZR         = 1; break; // l (button 8 pressed)
-                    case 0x19: m_buttons.ZR         = 0; break; // v (button 8 released)
-                    default:
-                        break;
-                }
-
-                ++i;
-            }
+    }
 
-        }
+    ICadeController::ICadeController(const bluetooth::Address *address) 
+    : EmulatedSwitchControllerImpl(address)
+    , m_keyboard(icade_bindings) { }
 
+    void ICadeController::SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile) {
+        EmulatedSwitchController::SetProfile(config, profile);
+        m_keyboard.Configure(profile);
     }
 
-    void ICadeController::ApplyButtonCombos(SwitchButtonData *buttons) {
-        // Combo for minus button
-        if (buttons->ZL && buttons->ZR && buttons->L) {
-            buttons->minus = 1;
-            buttons->ZL = 0;
-            buttons->ZR = 0;
-            buttons->L = 0;
-        }
-
-        // Combo for plus button
-        if (buttons->ZL && buttons->ZR && buttons->R) {
-            buttons->plus = 1;
-            buttons->ZL = 0;
-            buttons->ZR = 0;
-            buttons->R = 0;
-        }
+    void ICadeController::UpdateControllerState(const bluetooth::HidReport *report) {
+        auto icade_report = reinterpret_cast<const ICadeReportData *>(&report->data);
 
-        EmulatedSwitchController::ApplyButtonCombos(buttons);
+        if (icade_report->id == 0x01)
+            MaskToButtonData(m_keyboard.Apply(&icade_report->input0x01), &m_buttons);
     }
 
+    template class EmulatedSwitchControllerImpl<ICadeController>;
+
 }
@@ -15,33 +15,34 @@
  */
 #pragma once
 #include "emulated_switch_controller.hpp"
+#include "keyboard_translator.hpp"
 
 namespace ams::controller {
 
-    struct ICadeInputReport0x01 {
-        uint8_t keys[9];
-    } __attribute__((packed));
-
     struct ICadeReportData {
         uint8_t id;
         union {
-            ICadeInputReport0x01 input0x01;
+            BootKeyboardReport input0x01;
         };
     } __attribute__((packed));
 
-    class ICadeController : public EmulatedSwitchController {
+    class ICadeController : public EmulatedSwitchControllerImpl<ICadeController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
                 {0x15e4, 0x0132}    // ION iCade Controller
             };  
 
-            ICadeController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+            ICadeController(const bluetooth::Address *address);
 
+            void SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile);
             void UpdateControllerState(const bluetooth::HidReport *report);
-            void ApplyButtonCombos(SwitchButtonData *buttons) override;
+
+        private:
+            KeyboardTranslator m_keyboard;
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<ICadeController>;
+
 }
@@ -83,4 +83,6 @@ namespace ams::controller {
         m_buttons.rstick_press = src->input0x07.buttons.rstick_press;
     }
 
+    template class EmulatedSwitchControllerImpl<IpegaController>;
+
 }
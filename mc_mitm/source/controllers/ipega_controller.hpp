@@ -78,7 +78,7 @@ namespace ams::controller {
         };
     } __attribute__ ((__packed__));
 
-    class IpegaController : public EmulatedSwitchController {
+    class IpegaController : public EmulatedSwitchControllerImpl<IpegaController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -88,7 +88,7 @@ namespace ams::controller {
             };  
 
             IpegaController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -98,4 +98,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<IpegaController>;
+
 }
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "keyboard_controller.hpp"
+#include <stratosphere.hpp>
+
+namespace ams::controller {
+
+    namespace {
+
+        // Default player 1 layout used by MAME, which most keyboard encoders follow
+        constexpr KeyboardKeyBinding keyboard_bindings[] = {
+            {0x52, {SwitchButton_DpadUp,    mitm::KeyboardKeyAction_Hold}},   // Up arrow
+            {0x51, {SwitchButton_DpadDown,  mitm::KeyboardKeyAction_Hold}},   // Down arrow
+            {0x50, {SwitchButton_DpadLeft,  mitm::KeyboardKeyAction_Hold}},   // Left arrow
+            {0x4f, {SwitchButton_DpadRight, mitm::KeyboardKeyAction_Hold}},   // Right arrow
+            {0xe0, {SwitchButton_B,         mitm::KeyboardKeyAction_Hold}},   // Left control (button 1)
+            {0xe2, {SwitchButton_A,         mitm::KeyboardKeyAction_Hold}},   // Left alt (button 2)
+            {0x2c, {SwitchButton_Y,         mitm::KeyboardKeyAction_Hold}},   // Space (button 3)
+            {0xe1, {SwitchButton_X,         mitm::KeyboardKeyAction_Hold}},   // Left shift (button 4)
+            {0x1d, {SwitchButton_L,         mitm::KeyboardKeyAction_Hold}},   // z (button 5)
+            {0x1b, {SwitchButton_R,         mitm::KeyboardKeyAction_Hold}},   // x (button 6)
+            {0x06, {SwitchButton_ZL,        mitm::KeyboardKeyAction_Hold}},   // c (button 7)
+            {0x19, {SwitchButton_ZR,        mitm::KeyboardKeyAction_Hold}},   // v (button 8)
+            {0x1e, {SwitchButton_Plus,      mitm::KeyboardKeyAction_Hold}},   // 1 (start)
+            {0x22, {SwitchButton_Minus,     mitm::KeyboardKeyAction_Hold}},   // 5 (coin)
+            {0x29, {SwitchButton_Home,      mitm::KeyboardKeyAction_Hold}},   // Escape
+        };
+
+    }
+
+    KeyboardController::KeyboardController(const bluetooth::Address *address)
+    : EmulatedSwitchControllerImpl(address)
+    , m_keyboard(keyboard_bindings) { }
+
+    void KeyboardController::SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile) {
+        EmulatedSwitchController::SetProfile(config, profile);
+        m_keyboard.Configure(profile);
+    }
+
+    void KeyboardController::UpdateControllerState(const bluetooth::HidReport *report) {
+        auto keyboard_report = reinterpret_cast<const KeyboardReportData *>(&report->data);
+
+        if ((keyboard_report->id == 0x01) && (report->size >= sizeof(keyboard_report->id) + sizeof(BootKeyboardReport)))
+            MaskToButtonData(m_keyboard.Apply(&keyboard_report->input0x01), &m_buttons);
+    }
+
+    template class EmulatedSwitchControllerImpl<KeyboardController>;
+
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "emulated_switch_controller.hpp"
+#include "keyboard_translator.hpp"
+
+namespace ams::controller {
+
+    struct KeyboardReportData {
+        uint8_t id;
+        union {
+            BootKeyboardReport input0x01;
+        };
+    } __attribute__((packed));
+
+    // Generic handler for devices that identify as keyboards, eg. arcade stick encoders and pads in keyboard mode
+    class KeyboardController : public EmulatedSwitchControllerImpl<KeyboardController> {
+
+        public:
+            KeyboardController(const bluetooth::Address *address);
+
+            void SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile);
+            void UpdateControllerState(const bluetooth::HidReport *report);
+
+        private:
+            KeyboardTranslator m_keyboard;
+
+    };
+
+    extern template class EmulatedSwitchControllerImpl<KeyboardController>;
+
+}
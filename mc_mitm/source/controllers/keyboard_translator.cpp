@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "keyboard_translator.hpp"
+
+namespace ams::controller {
+
+    KeyboardTranslator::KeyboardTranslator(const KeyboardKeyBinding *bindings, size_t count)
+    : m_bindings(bindings)
+    , m_num_bindings(count)
+    , m_latched(0)
+    , m_buttons(0) {
+        this->Configure(nullptr);
+    }
+
+    void KeyboardTranslator::Configure(const mitm::ControllerProfileConfig *profile) {
+        for (size_t i = 0; i < mitm::NumKeyboardKeycodes; ++i)
+            m_keymap[i] = {0, mitm::KeyboardKeyAction_None};
+
+        for (size_t i = 0; i < m_num_bindings; ++i)
+            m_keymap[m_bindings[i].key] = m_bindings[i].mapping;
+
+        if (profile) {
+            for (size_t i = 0; i < profile->num_keymaps; ++i)
+                m_keymap[profile->keymap[i].key] = profile->keymap[i].mapping;
+        }
+    }
+
+    uint32_t KeyboardTranslator::Apply(const BootKeyboardReport *report) {
+        // Every slot reports ErrorRollOver when too many keys are down. Keep the last state rather than releasing everything
+        if (report->keys[0] == keyboard_usage_error_roll_over)
+            return m_buttons;
+
+        std::bitset<mitm::NumKeyboardKeycodes> keys;
+        uint32_t held = 0;
+
+        auto apply_key = [&](uint8_t key) {
+            if (keys.test(key))
+                return;
+
+            keys.set(key);
+
+            auto mapping = m_keymap[key];
+            switch (mapping.action) {
+                case mitm::KeyboardKeyAction_Hold:
+                    held |= mapping.buttons;
+                    break;
+                case mitm::KeyboardKeyAction_Press:
+                    if (!m_keys.test(key))
+                        m_latched |= mapping.buttons;
+                    break;
+                case mitm::KeyboardKeyAction_Release:
+                    if (!m_keys.test(key))
+                        m_latched &= ~mapping.buttons;
+                    break;
+                default:
+                    break;
+            }
+        };
+
+        // Modifier keys are reported as a bitfield rather than in the key array
+        for (unsigned int i = 0; i < 8; ++i) {
+            if (report->modifiers & BIT(i))
+                apply_key(keyboard_usage_left_control + i);
+        }
+
+        for (auto key : report->keys) {
+            if (key >= keyboard_usage_first_key)
+                apply_key(key);
+        }
+
+        m_keys = keys;
+        m_buttons = m_latched | held;
+        return m_buttons;
+    }
+
+}
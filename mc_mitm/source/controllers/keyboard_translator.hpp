@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <bitset>
+#include "../mcmitm_config.hpp"
+
+namespace ams::controller {
+
+    // Usage ids 0x01-0x03 are error codes rather than keys
+    constexpr uint8_t keyboard_usage_error_roll_over = 0x01;
+    constexpr uint8_t keyboard_usage_first_key       = 0x04;
+    constexpr uint8_t keyboard_usage_left_control    = 0xe0;
+
+    struct BootKeyboardReport {
+        uint8_t modifiers;
+        uint8_t _reserved;
+        uint8_t keys[6];
+    } __attribute__((packed));
+
+    using KeyboardKeyBinding = mitm::KeyboardKeyBinding;
+
+    // Translates boot protocol keyboard reports into switch buttons using a table indexed by usage id. Keys are compared
+    // against the previous report's key set, so the cost per report is bounded by the number of keys in the report
+    class KeyboardTranslator {
+
+        public:
+            template <size_t N>
+            KeyboardTranslator(const KeyboardKeyBinding (&bindings)[N]) : KeyboardTranslator(bindings, N) { };
+            KeyboardTranslator(const KeyboardKeyBinding *bindings, size_t count);
+
+            // Rebuild the keymap from the controller's bindings with any overrides from the profile applied
+            void Configure(const mitm::ControllerProfileConfig *profile);
+            uint32_t Apply(const BootKeyboardReport *report);
+
+        private:
+            const KeyboardKeyBinding *m_bindings;
+            size_t m_num_bindings;
+
+            mitm::KeyboardKeyMapping m_keymap[mitm::NumKeyboardKeycodes];
+            std::bitset<mitm::NumKeyboardKeycodes> m_keys;    // Keys down in the previous report
+            uint32_t m_latched;     // Buttons set by press and release actions
+            uint32_t m_buttons;
+    };
+
+}
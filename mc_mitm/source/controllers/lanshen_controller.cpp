@@ -76,4 +76,6 @@ namespace ams::controller {
         m_buttons.rstick_press = src->input0x01.buttons.R3;
     }
 
+    template class EmulatedSwitchControllerImpl<LanShenController>;
+
 }
@@ -72,7 +72,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class LanShenController : public EmulatedSwitchController {
+    class LanShenController : public EmulatedSwitchControllerImpl<LanShenController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -80,7 +80,7 @@ namespace ams::controller {
             };  
 
             LanShenController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -89,4 +89,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<LanShenController>;
+
 }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "load_governor.hpp"
+#include <atomic>
+
+namespace ams::controller {
+
+    namespace {
+
+        constexpr auto window_length = TimeSpan::FromMilliSeconds(250);
+
+        constexpr TimeSpan minimum_report_intervals[LoadLevel_Count] = {
+            TimeSpan::FromMilliSeconds(0),
+            TimeSpan::FromMilliSeconds(8),
+            TimeSpan::FromMilliSeconds(15),
+        };
+
+        std::atomic<uint32_t> g_budget_percent;
+        std::atomic<uint32_t> g_level;
+        std::atomic<uint32_t> g_last_window_percent;
+        std::atomic<uint32_t> g_level_changes;
+        std::atomic<int64_t> g_time_in_level[LoadLevel_Count];
+
+        // Only touched by the report thread
+        os::Tick g_window_start;
+        os::Tick g_window_busy;
+
+    }
+
+    void SetLoadBudget(uint32_t percent) {
+        g_budget_percent.store(percent, std::memory_order_relaxed);
+    }
+
+    void RecordTranslationWork(os::Tick start, os::Tick end) {
+        if (g_window_start.GetInt64Value() == 0)
+            g_window_start = start;
+
+        g_window_busy = g_window_busy + (end - start);
+
+        auto elapsed = end - g_window_start;
+        if (elapsed < os::ConvertToTick(window_length))
+            return;
+
+        uint32_t percent = (100 * g_window_busy.GetInt64Value()) / elapsed.GetInt64Value();
+        g_last_window_percent.store(percent, std::memory_order_relaxed);
+
+        auto level = g_level.load(std::memory_order_relaxed);
+        g_time_in_level[level].fetch_add(elapsed.GetInt64Value(), std::memory_order_relaxed);
+
+        // Step one level at a time, only restoring fidelity once load has dropped well below the budget
+        auto budget = g_budget_percent.load(std::memory_order_relaxed);
+        auto new_level = level;
+        if (budget == 0)
+            new_level = LoadLevel_Full;
+        else if ((percent > budget) && (level < LoadLevel_Count - 1))
+            ++new_level;
+        else if ((percent < budget / 2) && (level > LoadLevel_Full))
+            --new_level;
+
+        if (new_level != level) {
+            g_level.store(new_level, std::memory_order_relaxed);
+            g_level_changes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        g_window_start = end;
+        g_window_busy = os::Tick(0);
+    }
+
+    LoadLevel GetLoadLevel(void) {
+        return static_cast<LoadLevel>(g_level.load(std::memory_order_relaxed));
+    }
+
+    os::Tick GetMinimumReportInterval(void) {
+        return os::ConvertToTick(minimum_report_intervals[GetLoadLevel()]);
+    }
+
+    void GetLoadGovernorState(LoadGovernorState *out) {
+        out->level = g_level.load(std::memory_order_relaxed);
+        out->budget_percent = g_budget_percent.load(std::memory_order_relaxed);
+        out->last_window_percent = g_last_window_percent.load(std::memory_order_relaxed);
+        out->level_changes = g_level_changes.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < LoadLevel_Count; ++i)
+            out->time_in_level_ms[i] = os::ConvertToTimeSpan(os::Tick(g_time_in_level[i].load(std::memory_order_relaxed))).GetMilliSeconds();
+    }
+
+}
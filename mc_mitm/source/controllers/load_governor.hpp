@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+
+namespace ams::controller {
+
+    enum LoadLevel : uint32_t {
+        LoadLevel_Full,         // Every report is translated
+        LoadLevel_Decimate,     // Input reports limited to one every 8ms per controller
+        LoadLevel_Reduced,      // Input reports limited to one every 15ms, rumble and led updates rate limited
+
+        LoadLevel_Count
+    };
+
+    // Snapshot of the governor, as returned by the GetLoadGovernorState extension
+    struct LoadGovernorState {
+        uint32_t level;
+        uint32_t budget_percent;
+        uint32_t last_window_percent;   // Share of the last measurement window spent translating reports
+        uint32_t level_changes;
+        uint64_t time_in_level_ms[LoadLevel_Count];
+    };
+
+    void SetLoadBudget(uint32_t percent);
+    void RecordTranslationWork(os::Tick start, os::Tick end);
+
+    LoadLevel GetLoadLevel(void);
+    os::Tick GetMinimumReportInterval(void);
+    void GetLoadGovernorState(LoadGovernorState *out);
+
+}
@@ -86,4 +86,6 @@ namespace ams::controller {
         m_buttons.home = src->input0x02.play;
     }
 
+    template class EmulatedSwitchControllerImpl<MadCatzController>;
+
 }
@@ -81,7 +81,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class MadCatzController : public EmulatedSwitchController {
+    class MadCatzController : public EmulatedSwitchControllerImpl<MadCatzController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -90,7 +90,7 @@ namespace ams::controller {
             };  
 
             MadCatzController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -100,4 +100,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<MadCatzController>;
+
 }
@@ -79,7 +79,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class MocuteController : public EmulatedSwitchController {
+    class MocuteController : public EmulatedSwitchControllerImpl<MocuteController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -88,7 +88,7 @@ namespace ams::controller {
             };  
 
             MocuteController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -97,4 +97,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<MocuteController>;
+
 }
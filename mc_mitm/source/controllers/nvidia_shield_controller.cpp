@@ -85,4 +85,6 @@ namespace ams::controller {
 
     }
 
+    template class EmulatedSwitchControllerImpl<NvidiaShieldController>;
+
 }
@@ -74,7 +74,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class NvidiaShieldController : public EmulatedSwitchController {
+    class NvidiaShieldController : public EmulatedSwitchControllerImpl<NvidiaShieldController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -82,7 +82,7 @@ namespace ams::controller {
             };  
 
             NvidiaShieldController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -92,4 +92,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<NvidiaShieldController>;
+
 }
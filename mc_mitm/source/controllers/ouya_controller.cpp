@@ -78,4 +78,6 @@ namespace ams::controller {
         m_buttons.home    = src->input0x07.buttons.center_hold;
     }
 
+    template class EmulatedSwitchControllerImpl<OuyaController>;
+
 }
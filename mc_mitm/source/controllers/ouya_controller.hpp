@@ -64,7 +64,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class OuyaController : public EmulatedSwitchController {
+    class OuyaController : public EmulatedSwitchControllerImpl<OuyaController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -72,7 +72,7 @@ namespace ams::controller {
             };  
 
             OuyaController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -82,4 +82,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<OuyaController>;
+
 }
@@ -79,4 +79,6 @@ namespace ams::controller {
         m_buttons.rstick_press = src->input0x03.buttons.R3;
     }
 
+    template class EmulatedSwitchControllerImpl<PowerAController>;
+
 }
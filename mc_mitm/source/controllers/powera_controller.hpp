@@ -68,7 +68,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class PowerAController : public EmulatedSwitchController {
+    class PowerAController : public EmulatedSwitchControllerImpl<PowerAController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -78,7 +78,7 @@ namespace ams::controller {
             };  
 
             PowerAController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -87,4 +87,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<PowerAController>;
+
 }
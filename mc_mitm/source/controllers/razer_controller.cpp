@@ -79,4 +79,6 @@ namespace ams::controller {
         m_buttons.home    = src->input0x01.buttons.home;
     }
 
+    template class EmulatedSwitchControllerImpl<RazerController>;
+
 }
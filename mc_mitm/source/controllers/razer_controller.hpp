@@ -71,7 +71,7 @@ namespace ams::controller {
     } __attribute__((packed));
 
 
-    class RazerController : public EmulatedSwitchController {
+    class RazerController : public EmulatedSwitchControllerImpl<RazerController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -79,7 +79,7 @@ namespace ams::controller {
             };  
 
             RazerController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
@@ -88,4 +88,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<RazerController>;
+
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stratosphere.hpp>
+#include <cstring>
+#include <mutex>
+
+namespace ams::controller {
+
+    // Fixed pool of lookup tables compiled from a key, shared by every controller configured with an identical key.
+    // Only touched when controllers are configured, never per report
+    template <typename Key, typename Table, size_t NumTables>
+    class SharedTablePool {
+
+        public:
+            // Returns the table compiled from key, compiling it into a free slot if no controller holds one yet. Returns nullptr when the pool is exhausted
+            template <typename F>
+            const Table *Acquire(const Key *key, F compile) {
+                std::scoped_lock lk(m_lock);
+
+                Entry *free_entry = nullptr;
+                for (auto &entry : m_entries) {
+                    if (entry.refcount == 0) {
+                        if (!free_entry)
+                            free_entry = &entry;
+                    }
+                    else if (std::memcmp(&entry.key, key, sizeof(Key)) == 0) {
+                        ++entry.refcount;
+                        return &entry.table;
+                    }
+                }
+
+                if (!free_entry)
+                    return nullptr;
+
+                std::memcpy(&free_entry->key, key, sizeof(Key));
+                compile(&free_entry->table);
+                free_entry->refcount = 1;
+
+                return &free_entry->table;
+            }
+
+            void Release(const Table *table) {
+                if (!table)
+                    return;
+
+                std::scoped_lock lk(m_lock);
+
+                for (auto &entry : m_entries) {
+                    if (&entry.table == table) {
+                        AMS_ABORT_UNLESS(entry.refcount > 0);
+                        --entry.refcount;
+                        return;
+                    }
+                }
+            }
+
+        private:
+            struct Entry {
+                size_t refcount;
+                Key key;
+                Table table;
+            };
+
+            os::SdkMutex m_lock;
+            Entry m_entries[NumTables];
+    };
+
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <switch.h>
+#include <stratosphere.hpp>
+#include <cstring>
+#include "controller_utils.hpp"
+#include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
+
+namespace ams::controller {
+
+    // Bluetooth output report for Sony controllers, built once from a template. Rumble and led fields are patched in place,
+    // and the report is only rebuilt when one of them changes. T must be a packed report with a data[] array starting at the 0xa2 header byte, followed by the crc
+    template <typename T>
+    class SonyOutputReport {
+
+        public:
+            SonyOutputReport(void) : m_report({}), m_header_size(0), m_dirty(true) { }
+
+            // Replace the constant header. Setting the header already present is a no-op, so it is cheap to call on every push
+            void SetHeader(const uint8_t *header, size_t header_size) {
+                AMS_ABORT_UNLESS(header_size <= sizeof(m_report.data));
+
+                if ((header_size == m_header_size) && (std::memcmp(m_report.data, header, header_size) == 0))
+                    return;
+
+                std::memcpy(m_report.data, header, header_size);
+                m_header_size = header_size;
+                m_dirty = true;
+            }
+
+            // Set a byte following the header. Writing the value already present leaves the report clean
+            void Set(size_t offset, uint8_t value) {
+                AMS_ASSERT(offset >= m_header_size && offset < sizeof(m_report.data));
+
+                if (m_report.data[offset] != value) {
+                    m_report.data[offset] = value;
+                    m_dirty = true;
+                }
+            }
+
+            bool IsDirty(void) const {
+                return m_dirty;
+            }
+
+            // Copy the report, minus the 0xa2 header byte, to be sent and append the crc.
+            // The mutable fields sit just past the header, so there is no sizeable constant prefix worth resuming the crc from
+            void Build(bluetooth::HidReport *out) {
+                uint32_t crc = ~crc32_update(crc32_initial_state, m_report.data, sizeof(m_report.data));
+
+                out->size = sizeof(m_report) - 1;
+                std::memcpy(out->data, &m_report.data[1], sizeof(m_report.data) - 1);
+                std::memcpy(&out->data[sizeof(m_report.data) - 1], &crc, sizeof(crc));
+            }
+
+            // The built report reached the controller, so it needn't be sent again until something changes
+            void MarkSent(void) {
+                m_dirty = false;
+            }
+
+        private:
+            T m_report;
+            size_t m_header_size;
+            bool m_dirty;
+    };
+
+}
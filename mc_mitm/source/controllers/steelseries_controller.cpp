@@ -22,24 +22,44 @@ namespace ams::controller {
 
         const constexpr float stick_scale_factor = float(UINT12_MAX) / UINT8_MAX;
 
+        // MFi reports carry no id, so they are told apart from the numbered reports by size alone
+        constexpr size_t max_hid_report_size = sizeof(SteelseriesInputReport0xc4) + 1;
+        static_assert(max_hid_report_size < sizeof(SteelseriesMfiInputReport));
+        static_assert(sizeof(SteelseriesInputReport0x01) + 1 <= max_hid_report_size);
+        static_assert(sizeof(SteelseriesInputReport0x12) + 1 <= max_hid_report_size);
+
+    }
+
+    void SteelseriesController::BindReportFormat(SteelseriesReportFormat format) {
+        m_input_handler = format == SteelseriesReportFormat_Mfi ? &SteelseriesController::HandleMfiInputReport : &SteelseriesController::HandleHidInputReport;
     }
 
     void SteelseriesController::UpdateControllerState(const bluetooth::HidReport *report) {
-        auto steelseries_report = reinterpret_cast<const SteelseriesReportData *>(&report->data);
+        (this->*m_input_handler)(report);
+    }
 
-        switch(steelseries_report->id) {
+    void SteelseriesController::DetectInputReport(const bluetooth::HidReport *report) {
+        // Numbered reports are at most 12 bytes including the id (0xc4 being the largest), and MFi reports are 17
+        this->BindReportFormat(report->size > max_hid_report_size ? SteelseriesReportFormat_Mfi : SteelseriesReportFormat_Hid);
+        (this->*m_input_handler)(report);
+    }
+
+    void SteelseriesController::HandleHidInputReport(const bluetooth::HidReport *report) {
+        if (report->size > max_hid_report_size)
+            return this->DetectInputReport(report);
+
+        auto src = reinterpret_cast<const SteelseriesReportData *>(&report->data);
+        switch(src->id) {
             case 0x01:
-                this->HandleInputReport0x01(steelseries_report);
+                this->HandleInputReport0x01(src);
                 break;
             case 0x12:
-                this->HandleInputReport0x12(steelseries_report);
+                this->HandleInputReport0x12(src);
                 break;
             case 0xc4:
-                this->HandleInputReport0xc4(steelseries_report);
+                this->HandleInputReport0xc4(src);
                 break;
             default:
-                // Todo: handle this properly
-                this->HandleMfiInputReport(steelseries_report);
                 break;
         }
     }
@@ -123,7 +143,11 @@ namespace ams::controller {
         m_buttons.plus  = src->input0xc4.buttons.start;
     }
 
-    void SteelseriesController::HandleMfiInputReport(const SteelseriesReportData *src) {
+    void SteelseriesController::HandleMfiInputReport(const bluetooth::HidReport *report) {
+        if (report->size <= max_hid_report_size)
+            return this->DetectInputReport(report);
+
+        auto src = reinterpret_cast<const SteelseriesReportData *>(&report->data);
         m_left_stick.SetData(
             static_cast<uint16_t>(stick_scale_factor * -static_cast<int8_t>(~src->input_mfi.left_stick.x + 1) + 0x7ff) & 0xfff,
             static_cast<uint16_t>(stick_scale_factor * (-static_cast<int8_t>(~src->input_mfi.left_stick.y + 1)) + 0x7ff) & 0xfff
@@ -151,4 +175,6 @@ namespace ams::controller {
         m_buttons.home = src->input_mfi.buttons.menu;
     }
 
+    template class EmulatedSwitchControllerImpl<SteelseriesController>;
+
 }
@@ -18,6 +18,11 @@
 
 namespace ams::controller {
 
+    enum SteelseriesReportFormat : uint8_t {
+        SteelseriesReportFormat_Hid,    // Numbered reports 0x01, 0x12 and 0xc4
+        SteelseriesReportFormat_Mfi     // Unnumbered MFi reports
+    };
+
     enum SteelseriesDPadDirection {
         SteelseriesDPad_N,
         SteelseriesDPad_NE,
@@ -150,7 +155,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class SteelseriesController : public EmulatedSwitchController {
+    class SteelseriesController : public EmulatedSwitchControllerImpl<SteelseriesController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = {
@@ -160,15 +165,25 @@ namespace ams::controller {
             };
 
             SteelseriesController(const bluetooth::Address *address)
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address)
+                , m_input_handler(&SteelseriesController::DetectInputReport) { };
 
             void UpdateControllerState(const bluetooth::HidReport *report);
 
         private:
+            void BindReportFormat(SteelseriesReportFormat format);
+
+            void DetectInputReport(const bluetooth::HidReport *report);
+            void HandleHidInputReport(const bluetooth::HidReport *report);
             void HandleInputReport0x01(const SteelseriesReportData *src);
             void HandleInputReport0x12(const SteelseriesReportData *src);
             void HandleInputReport0xc4(const SteelseriesReportData *src);
-            void HandleMfiInputReport(const SteelseriesReportData *src);
+            void HandleMfiInputReport(const bluetooth::HidReport *report);
+
+            // Bound to the handler for the detected format. Each handler only checks the report size, redetecting if it no longer fits
+            void (SteelseriesController::*m_input_handler)(const bluetooth::HidReport *report);
     };
 
+    extern template class EmulatedSwitchControllerImpl<SteelseriesController>;
+
 }
@@ -14,6 +14,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "switch_controller.hpp"
+#include "controller_state_feed.hpp"
+#include "../mcmitm_config.hpp"
+#include <atomic>
 
 namespace ams::controller {
 
@@ -38,6 +41,8 @@ namespace ams::controller {
             SwitchPlayerNumber_Four,    //1111
         };
 
+        std::atomic<bool> g_pacing_service_requested;
+
     }
 
     Result LedsMaskToPlayerNumber(uint8_t led_mask, uint8_t *player_number) {
@@ -48,39 +53,92 @@ namespace ams::controller {
         return ams::ResultSuccess();
     }
 
+    void RequestPacingService(void) {
+        g_pacing_service_requested.store(true, std::memory_order_release);
+    }
+
+    bool ConsumePacingServiceRequest(void) {
+        return g_pacing_service_requested.exchange(false, std::memory_order_acq_rel);
+    }
+
     bluetooth::HidReport SwitchController::s_input_report;
     bluetooth::HidReport SwitchController::s_output_report;
+    os::SdkMutex SwitchController::s_output_report_lock;
 
-    Result SwitchController::HandleIncomingReport(const bluetooth::HidReport *report) {
-        s_input_report.size = report->size;
-	    std::memcpy(s_input_report.data, report->data, report->size);
+    void SwitchController::SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile) {
+        // Combos can be disabled for official controllers. With no combos or remaps left to apply, reports are passed straight through
+        if (profile && (!this->IsOfficialController() || config->misc.enable_official_controller_combos))
+            m_combos.Configure(profile->combos, profile->num_combos);
+        else
+            m_combos.Configure(nullptr, 0);
+
+        m_remap.Configure(profile);
+    }
 
-        auto switch_report = reinterpret_cast<SwitchReportData *>(s_input_report.data);
-        if (switch_report->id == 0x30) {
-            this->ApplyButtonCombos(&switch_report->input0x30.buttons);
+    Result SwitchController::HandleIncomingReport(const bluetooth::HidReport *report) {
+        // Nothing to modify, pass the report straight through
+        if (!m_combos.IsEnabled() && !m_remap.IsEnabled()) {
+            this->PublishInputReport(reinterpret_cast<const SwitchReportData *>(report->data));
+            return this->WriteHidReportBuffer(report);
         }
 
-        return bluetooth::hid::report::WriteHidReportBuffer(&m_address, &s_input_report);
+        // Copy directly into the report buffer and modify buttons in place
+        return this->WriteHidReportBuffer(report->size, [this, report](bluetooth::HidReport *dst) {
+            std::memcpy(dst, report, report->size + sizeof(report->size));
+
+            auto switch_report = reinterpret_cast<SwitchReportData *>(dst->data);
+            if (switch_report->id == 0x30) {
+                this->ApplyButtonProfile(&switch_report->input0x30.buttons);
+            }
+
+            this->PublishInputReport(switch_report);
+        });
     }
 
     Result SwitchController::HandleOutgoingReport(const bluetooth::HidReport *report) {
-        return bluetooth::hid::report::SendHidReport(&m_address, report);
+        return this->SendHidReport(report);
     }
 
-    void SwitchController::ApplyButtonCombos(SwitchButtonData *buttons) {
-        // Home combo = MINUS + DPAD_DOWN
-        if (buttons->minus && buttons->dpad_down) {
-            buttons->home = 1;
-            buttons->minus = 0;
-            buttons->dpad_down = 0;
-        }
+    Result SwitchController::WriteHidReportBuffer(const bluetooth::HidReport *report) {
+        u64 pending = 0;
+        auto rc = bluetooth::hid::report::WriteHidReportBuffer(&m_address, report, &pending);
+        this->RecordBufferWrite(rc, pending);
 
-        // Capture combo = MINUS + DPAD_UP
-        if (buttons->minus && buttons->dpad_up) {
-            buttons->capture = 1;
-            buttons->minus = 0;
-            buttons->dpad_up = 0;
+        return rc;
+    }
+
+    void SwitchController::RecordBufferWrite(Result rc, u64 pending) {
+        if (R_FAILED(rc)) {
+            m_stats.RecordBufferFullDrop();
+            return;
         }
+
+        // How far behind the fake buffer consumer was when the report was written, for judging how many controllers the pipeline can keep up with
+        m_stats.RecordBufferOccupancy(pending);
+    }
+
+    Result SwitchController::SendHidReport(const bluetooth::HidReport *report) {
+        m_stats.RecordReportSent();
+        return bluetooth::hid::report::SendHidReport(&m_address, report);
+    }
+
+    void SwitchController::PublishInputReport(const SwitchReportData *report) {
+        if (m_state_slot && (report->id == 0x30))
+            PublishState(m_state_slot, &report->input0x30);
+    }
+
+    void SwitchController::ApplyButtonProfile(SwitchButtonData *buttons) {
+        MaskToButtonData(this->ApplyButtonProfile(ButtonDataToMask(buttons)), buttons);
+    }
+
+    uint32_t SwitchController::ApplyButtonProfile(uint32_t buttons) {
+        buttons = m_combos.Apply(buttons);
+
+        // Remapping is applied to the final button state
+        if (m_remap.IsEnabled())
+            buttons = m_remap.Apply(buttons);
+
+        return buttons;
     }
 
 }
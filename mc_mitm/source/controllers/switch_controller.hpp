@@ -15,6 +15,9 @@
  */
 #pragma once
 #include "switch_analog_stick.hpp"
+#include "button_combos.hpp"
+#include "button_remap.hpp"
+#include "controller_stats.hpp"
 #include "../bluetooth_mitm/bluetooth/bluetooth_types.hpp"
 #include "../bluetooth_mitm/bluetooth/bluetooth_hid_report.hpp"
 
@@ -78,6 +81,44 @@ namespace ams::controller {
         uint8_t ZL             : 1;
     } __attribute__ ((__packed__));
 
+    // Button masks for SwitchButtonData treated as a 24-bit little endian word
+    enum SwitchButton : uint32_t {
+        SwitchButton_Y          = BIT(0),
+        SwitchButton_X          = BIT(1),
+        SwitchButton_B          = BIT(2),
+        SwitchButton_A          = BIT(3),
+        SwitchButton_RightSR    = BIT(4),
+        SwitchButton_RightSL    = BIT(5),
+        SwitchButton_R          = BIT(6),
+        SwitchButton_ZR         = BIT(7),
+        SwitchButton_Minus      = BIT(8),
+        SwitchButton_Plus       = BIT(9),
+        SwitchButton_RStick     = BIT(10),
+        SwitchButton_LStick     = BIT(11),
+        SwitchButton_Home       = BIT(12),
+        SwitchButton_Capture    = BIT(13),
+        SwitchButton_DpadDown   = BIT(16),
+        SwitchButton_DpadUp     = BIT(17),
+        SwitchButton_DpadRight  = BIT(18),
+        SwitchButton_DpadLeft   = BIT(19),
+        SwitchButton_LeftSR     = BIT(20),
+        SwitchButton_LeftSL     = BIT(21),
+        SwitchButton_L          = BIT(22),
+        SwitchButton_ZL         = BIT(23),
+    };
+
+    inline uint32_t ButtonDataToMask(const SwitchButtonData *buttons) {
+        auto data = reinterpret_cast<const uint8_t *>(buttons);
+        return data[0] | (data[1] << 8) | (data[2] << 16);
+    }
+
+    inline void MaskToButtonData(uint32_t mask, SwitchButtonData *buttons) {
+        auto data = reinterpret_cast<uint8_t *>(buttons);
+        data[0] = mask & 0xff;
+        data[1] = (mask >> 8) & 0xff;
+        data[2] = (mask >> 16) & 0xff;
+    }
+
     struct Switch6AxisData {
         uint16_t    accel_x;
         uint16_t    accel_y;
@@ -241,6 +282,12 @@ namespace ams::controller {
 
     Result LedsMaskToPlayerNumber(uint8_t led_mask, uint8_t *player_number);
 
+    // Flags that a controller may have started needing ServicePacing calls, so the report thread scans every controller again
+    void RequestPacingService(void);
+    bool ConsumePacingServiceRequest(void);
+
+    struct ControllerStateSlot;
+
     class SwitchController {
 
         public: 
@@ -252,24 +299,63 @@ namespace ams::controller {
             };
 
             SwitchController(const bluetooth::Address *address)
-                : m_address(*address) { };
+                : m_address(*address)
+                , m_hardware_id({})
+                , m_state_slot(nullptr) { };
+
+            virtual ~SwitchController(void) { };
 
             const bluetooth::Address& Address(void) const { return m_address; }
+            const HardwareID& GetHardwareId(void) const { return m_hardware_id; }
+            void SetHardwareId(const HardwareID& id) { m_hardware_id = id; }
+            ControllerStats *GetStats(void) { return &m_stats; }
+            ControllerStateSlot *GetStateSlot(void) { return m_state_slot; }
+            void SetStateSlot(ControllerStateSlot *slot) { m_state_slot = slot; }
 
             virtual bool IsOfficialController(void) { return true; }
             virtual bool SupportsSetTsiCommand(void) { return true; }
 
+            // Called with the tsi requested by the console when the controller doesn't support the command itself
+            virtual void SetTsi(uint8_t tsi) { };
+
+            virtual void SetProfile(const mitm::MissionControlConfig *config, const mitm::ControllerProfileConfig *profile);
+
+            // Called periodically from the report thread. Returns false if the controller does not pace its reports
+            virtual bool ServicePacing(os::Tick now, os::Tick *deadline) { return false; }
+
             virtual Result Initialize(void) { return ams::ResultSuccess(); }
             virtual Result HandleIncomingReport(const bluetooth::HidReport *report);
             virtual Result HandleOutgoingReport(const bluetooth::HidReport *report);
 
         protected:
-            virtual void ApplyButtonCombos(SwitchButtonData *buttons);
+            void ApplyButtonProfile(SwitchButtonData *buttons);
+            uint32_t ApplyButtonProfile(uint32_t buttons);
+            void PublishInputReport(const SwitchReportData *report);
+
+            Result WriteHidReportBuffer(const bluetooth::HidReport *report);
+            Result SendHidReport(const bluetooth::HidReport *report);
+            void RecordBufferWrite(Result rc, u64 pending);
+
+            template <typename F>
+            Result WriteHidReportBuffer(u16 report_size, F populate) {
+                u64 pending = 0;
+                auto rc = bluetooth::hid::report::WriteHidReportBuffer(&m_address, report_size, populate, &pending);
+                this->RecordBufferWrite(rc, pending);
+
+                return rc;
+            }
 
             bluetooth::Address m_address;
+            HardwareID m_hardware_id;
+            ButtonCombos m_combos;
+            ButtonRemap m_remap;
+            ControllerStats m_stats;
+            ControllerStateSlot *m_state_slot;
 
             static bluetooth::HidReport s_input_report;
+            // Shared by every controller. Output reports are built from both the ipc and report threads, so hold s_output_report_lock while using it
             static bluetooth::HidReport s_output_report;
+            static os::SdkMutex s_output_report_lock;
     };
 
 }
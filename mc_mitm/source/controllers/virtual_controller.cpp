@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "virtual_controller.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ams::controller {
+
+    namespace {
+
+        constexpr size_t virtual_controller_sharedmem_size = 0x1000;
+
+        os::SystemEvent g_input_event(os::EventClearMode_AutoClear, true);
+
+    }
+
+    os::SystemEvent *GetVirtualInputEvent(void) {
+        return &g_input_event;
+    }
+
+    bool VirtualController::IsVirtualAddress(const bluetooth::Address *address) {
+        return std::memcmp(address, &address_prefix, sizeof(bluetooth::Address) - 1) == 0;
+    }
+
+    VirtualController::VirtualController(const bluetooth::Address *address)
+    : EmulatedSwitchControllerImpl(address)
+    , m_shmem({})
+    , m_rings(nullptr) {
+        m_colours.body    = {0x4d, 0x43, 0x56};
+        m_colours.buttons = {0xff, 0xff, 0xff};
+    }
+
+    VirtualController::~VirtualController(void) {
+        if (m_rings)
+            shmemClose(&m_shmem);
+    }
+
+    Result VirtualController::Initialize(void) {
+        R_TRY(shmemCreate(&m_shmem, virtual_controller_sharedmem_size, Perm_Rw, Perm_Rw));
+        R_TRY(shmemMap(&m_shmem));
+
+        // Newly created shared memory is zero filled, so both rings start out empty
+        m_rings = reinterpret_cast<VirtualControllerSharedMemory *>(shmemGetAddr(&m_shmem));
+
+        return ams::ResultSuccess();
+    }
+
+    bool VirtualController::ServicePacing(os::Tick now, os::Tick *deadline) {
+        // A head further ahead than the ring holds means the client has corrupted it, so throw its contents away rather than trust it
+        if (m_rings->input.Pending() > VirtualControllerRingEntries) {
+            m_rings->input.Reset();
+        }
+
+        // Drain what the client has queued, holding on to presses so taps shorter than the pacing interval aren't lost. At most one ring's
+        // worth is taken per service, so a client writing as fast as frames are read can't hold up the other controllers
+        bool updated = false;
+        VirtualControllerInputFrame frame;
+        for (size_t i = 0; (i < VirtualControllerRingEntries) && m_rings->input.Pop(&frame); ++i) {
+            this->ApplyInputFrame(&frame);
+            m_pacing_buttons |= ButtonDataToMask(&m_buttons);
+            updated = true;
+        }
+
+        if (updated)
+            this->ForwardInputReport();
+
+        // Come back for anything left over on the next scan
+        if (m_rings->input.Pending() != 0)
+            RequestPacingService();
+
+        // Frames written later wake the report thread through the input event, so only pacing needs a deadline
+        return EmulatedSwitchController::ServicePacing(now, deadline);
+    }
+
+    void VirtualController::ApplyInputFrame(const VirtualControllerInputFrame *frame) {
+        MaskToButtonData(frame->buttons, &m_buttons);
+
+        m_left_stick.SetData(frame->left_stick_x & UINT12_MAX, frame->left_stick_y & UINT12_MAX);
+        m_right_stick.SetData(frame->right_stick_x & UINT12_MAX, frame->right_stick_y & UINT12_MAX);
+
+        // The lowest bit of the battery field is the charging flag
+        m_battery = std::min<uint8_t>(frame->battery, BATTERY_MAX) & ~1;
+        m_charging = frame->charging != 0;
+
+        std::memcpy(m_motion_data, frame->motion, sizeof(m_motion_data));
+    }
+
+    Result VirtualController::SetVibration(const SwitchRumbleData *rumble_data) {
+        VirtualControllerOutputFrame frame = {};
+        frame.type = VirtualControllerOutput_Rumble;
+        frame.rumble = *rumble_data;
+
+        // Drop the update if the client isn't keeping up rather than stalling the caller
+        if (!m_rings->output.Push(&frame))
+            m_stats.RecordRumbleSuppressed();
+
+        return ams::ResultSuccess();
+    }
+
+    Result VirtualController::SetPlayerLed(uint8_t led_mask) {
+        VirtualControllerOutputFrame frame = {};
+        frame.type = VirtualControllerOutput_PlayerLed;
+        frame.led_mask = led_mask;
+
+        m_rings->output.Push(&frame);
+
+        return ams::ResultSuccess();
+    }
+
+    template class EmulatedSwitchControllerImpl<VirtualController>;
+
+}
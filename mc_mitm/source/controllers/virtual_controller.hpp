@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020-2021 ndeadly
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include "emulated_switch_controller.hpp"
+#include <atomic>
+
+namespace ams::controller {
+
+    constexpr size_t MaxVirtualControllers = 4;
+    constexpr size_t VirtualControllerRingEntries = 16;
+
+    // Signalled by clients after writing to an input ring, to wake the report thread
+    os::SystemEvent *GetVirtualInputEvent(void);
+
+    // Single producer, single consumer ring. Head is only advanced by the producer and tail by the consumer. Both live in memory the
+    // client can write, so the side reading the other's index must not trust it further than the ring's size
+    template <typename T, size_t N>
+    struct VirtualControllerRing {
+        static_assert((N & (N - 1)) == 0, "Ring size must be a power of two");
+
+        alignas(64) std::atomic<uint32_t> head;
+        alignas(64) std::atomic<uint32_t> tail;
+        T entries[N];
+
+        bool Push(const T *entry) {
+            auto h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) >= N)
+                return false;
+
+            entries[h & (N - 1)] = *entry;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Entries waiting to be popped. More than N can only come from a misbehaving producer
+        uint32_t Pending(void) const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+        }
+
+        // Discards everything the producer has written
+        void Reset(void) {
+            tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        bool Pop(T *entry) {
+            auto t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire))
+                return false;
+
+            *entry = entries[t & (N - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    struct VirtualControllerInputFrame {
+        uint32_t buttons;       // SwitchButton mask
+        uint16_t left_stick_x;
+        uint16_t left_stick_y;
+        uint16_t right_stick_x;
+        uint16_t right_stick_y;
+        uint8_t battery;        // 0, 2, 4, 6 or 8
+        uint8_t charging;
+        uint8_t reserved[2];
+        Switch6AxisData motion[3];
+        uint8_t reserved2[12];
+    } __attribute__ ((__packed__));
+    static_assert(sizeof(VirtualControllerInputFrame) == 64);
+
+    enum VirtualControllerOutputType : uint8_t {
+        VirtualControllerOutput_Rumble,
+        VirtualControllerOutput_PlayerLed,
+    };
+
+    struct VirtualControllerOutputFrame {
+        uint8_t type;
+        uint8_t led_mask;
+        uint8_t reserved[2];
+        SwitchRumbleData rumble;
+        uint8_t reserved2[12];
+    } __attribute__ ((__packed__));
+    static_assert(sizeof(VirtualControllerOutputFrame) == 32);
+
+    // Layout of the shared memory handed out to the client that created the controller
+    struct VirtualControllerSharedMemory {
+        VirtualControllerRing<VirtualControllerInputFrame, VirtualControllerRingEntries> input;     // Client -> mc.mitm
+        VirtualControllerRing<VirtualControllerOutputFrame, VirtualControllerRingEntries> output;   // mc.mitm -> client
+    };
+    static_assert(sizeof(VirtualControllerSharedMemory) <= 0x1000);
+
+    class VirtualController : public EmulatedSwitchControllerImpl<VirtualController> {
+
+        public:
+            static constexpr const bluetooth::Address address_prefix = {{0x4d, 0x43, 0x56, 0x43, 0x00, 0x00}};
+
+            static bool IsVirtualAddress(const bluetooth::Address *address);
+
+            VirtualController(const bluetooth::Address *address);
+            ~VirtualController(void);
+
+            // There is no real link to configure, so tsi changes are always faked
+            bool SupportsSetTsiCommand(void) { return false; }
+
+            Result Initialize(void);
+            bool ServicePacing(os::Tick now, os::Tick *deadline);
+
+            // Input is read from the shared memory ring rather than arriving as HID reports
+            void UpdateControllerState(const bluetooth::HidReport *report) { };
+
+            Handle GetSharedMemoryHandle(void) { return m_shmem.handle; }
+
+        protected:
+            void ApplyInputFrame(const VirtualControllerInputFrame *frame);
+            Result SetVibration(const SwitchRumbleData *rumble_data);
+            Result SetPlayerLed(uint8_t led_mask);
+
+            SharedMemory m_shmem;
+            VirtualControllerSharedMemory *m_rings;
+
+    };
+
+    extern template class EmulatedSwitchControllerImpl<VirtualController>;
+
+}
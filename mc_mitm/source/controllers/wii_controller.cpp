@@ -310,6 +310,8 @@ namespace ams::controller {
     }
 
     Result WiiController::WriteMemory(uint32_t write_addr, const uint8_t *data, uint8_t size) {
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x16) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x16;
@@ -317,68 +319,82 @@ namespace ams::controller {
         report_data->output0x16.size = size;
         std::memcpy(&report_data->output0x16.data, data, size);
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
     Result WiiController::ReadMemory(uint32_t read_addr, uint16_t size) {
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x17) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x17;
         report_data->output0x17.address = ams::util::SwapBytes(read_addr);
         report_data->output0x17.size = ams::util::SwapBytes(size);
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
     Result WiiController::SetReportMode(uint8_t mode) {
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x12) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x12;
         report_data->output0x12.rumble = m_rumble_state;
         report_data->output0x12.report_mode = mode;
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
     Result WiiController::QueryStatus(void) {
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x15) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x15;
         report_data->output0x15.rumble = m_rumble_state;
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
     Result WiiController::SetVibration(const SwitchRumbleData *rumble_data) {
         m_rumble_state = rumble_data->high_band_amp > 0; //rumble_data->low_band_amp > 0 || rumble_data->high_band_amp > 0;
 
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x10) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x10;
         report_data->output0x10.rumble = m_rumble_state;
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
     Result WiiController::CancelVibration(void) {
         m_rumble_state = 0;
 
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x10) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x10;
         report_data->output0x10.rumble = m_rumble_state;
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
     Result WiiController::SetPlayerLed(uint8_t led_mask) {
+        std::scoped_lock lk(s_output_report_lock);
+
         s_output_report.size = sizeof(WiiOutputReport0x11) + 1;
         auto report_data = reinterpret_cast<WiiReportData *>(s_output_report.data);
         report_data->id = 0x11;
         report_data->output0x11.rumble = m_rumble_state;
         report_data->output0x11.leds = led_mask & 0xf;
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        return this->SendHidReport(&s_output_report);
     }
 
+    template class EmulatedSwitchControllerImpl<WiiController>;
+
 }
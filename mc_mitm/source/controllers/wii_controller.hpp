@@ -285,7 +285,7 @@ namespace ams::controller {
         };
     } __attribute__ ((__packed__));
 
-    class WiiController : public EmulatedSwitchController {
+    class WiiController : public EmulatedSwitchControllerImpl<WiiController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -294,7 +294,7 @@ namespace ams::controller {
             };
 
             WiiController(const bluetooth::Address *address)    
-                : EmulatedSwitchController(address)
+                : EmulatedSwitchControllerImpl(address)
                 , m_extension(WiiExtensionController_None)
                 , m_rumble_state(0) { };
 
@@ -332,4 +332,6 @@ namespace ams::controller {
             bool m_rumble_state;
     };
 
+    extern template class EmulatedSwitchControllerImpl<WiiController>;
+
 }
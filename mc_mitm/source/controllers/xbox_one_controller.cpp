@@ -23,20 +23,48 @@ namespace ams::controller {
 
         constexpr float stick_scale_factor = float(UINT12_MAX) / UINT16_MAX;
 
+        // Each rumble command keeps the motors running for this long, and is refreshed shortly before it lapses.
+        // A stalled rumble stream can't leave the motors running for longer than this
+        constexpr auto rumble_command_duration = TimeSpan::FromMilliSeconds(250);
+        constexpr auto rumble_refresh_margin = TimeSpan::FromMilliSeconds(50);
+
     }
 
     Result XboxOneController::SetVibration(const SwitchRumbleData *rumble_data) {
+        uint8_t strong = static_cast<uint8_t>(100 * rumble_data->low_band_amp);
+        uint8_t weak = static_cast<uint8_t>(100 * rumble_data->high_band_amp);
+        bool stop = (strong == 0) && (weak == 0);
+
+        // The console streams rumble continuously. Only send a command when the magnitude changes or the running one is about to lapse
+        auto now = os::GetSystemTick();
+        if ((strong == m_rumble_strong) && (weak == m_rumble_weak) && (stop || (now + os::ConvertToTick(rumble_refresh_margin) < m_rumble_expiry))) {
+            m_stats.RecordRumbleSuppressed();
+            return ams::ResultSuccess();
+        }
+
+        std::scoped_lock lk(s_output_report_lock);
+
         auto report = reinterpret_cast<XboxOneReportData *>(s_output_report.data);
         s_output_report.size = sizeof(XboxOneOutputReport0x03) + 1;
         report->id = 0x03;
         report->output0x03.enable                = 0x3;
-        report->output0x03.magnitude_strong      = static_cast<uint8_t>(100 * rumble_data->low_band_amp);
-        report->output0x03.magnitude_weak        = static_cast<uint8_t>(100 * rumble_data->high_band_amp);
-        report->output0x03.pulse_sustain_10ms    = 1;
+        report->output0x03.magnitude_strong      = strong;
+        report->output0x03.magnitude_weak        = weak;
+        report->output0x03.pulse_sustain_10ms    = stop ? 0 : rumble_command_duration.GetMilliSeconds() / 10;
         report->output0x03.pulse_release_10ms    = 0;
         report->output0x03.loop_count            = 0;
 
-        return bluetooth::hid::report::SendHidReport(&m_address, &s_output_report);
+        R_TRY(this->SendHidReport(&s_output_report));
+
+        m_rumble_strong = strong;
+        m_rumble_weak = weak;
+        m_rumble_expiry = now + os::ConvertToTick(rumble_command_duration);
+
+        return ams::ResultSuccess();
+    }
+
+    void XboxOneController::BindReportFormat(XboxOneReportFormat format) {
+        m_input0x01_handler = format == XboxOneReportFormat_Old ? &XboxOneController::HandleInputReport0x01Old : &XboxOneController::HandleInputReport0x01;
     }
 
     void XboxOneController::UpdateControllerState(const bluetooth::HidReport *report) {
@@ -44,7 +72,7 @@ namespace ams::controller {
 
         switch(xbox_report->id) {
             case 0x01:
-                this->HandleInputReport0x01(xbox_report, report->size == sizeof(XboxOneInputReport0x01) + 1);
+                (this->*m_input0x01_handler)(report);
                 break;
             case 0x02:
                 this->HandleInputReport0x02(xbox_report);
@@ -57,77 +85,82 @@ namespace ams::controller {
         }
     }
 
-    void XboxOneController::HandleInputReport0x01(const XboxOneReportData *src, bool new_format) {
-        m_left_stick.SetData(
-            static_cast<uint16_t>(stick_scale_factor * src->input0x01.left_stick.x) & 0xfff,
-            static_cast<uint16_t>(stick_scale_factor * (UINT16_MAX - src->input0x01.left_stick.y)) & 0xfff
-        );
-        m_right_stick.SetData(
-            static_cast<uint16_t>(stick_scale_factor * src->input0x01.right_stick.x) & 0xfff,
-            static_cast<uint16_t>(stick_scale_factor * (UINT16_MAX - src->input0x01.right_stick.y)) & 0xfff
-        );
+    void XboxOneController::DetectInputReport0x01(const bluetooth::HidReport *report) {
+        // Only newer firmware sends full size reports
+        this->BindReportFormat(report->size == sizeof(XboxOneInputReport0x01) + 1 ? XboxOneReportFormat_New : XboxOneReportFormat_Old);
+        (this->*m_input0x01_handler)(report);
+    }
 
-        m_buttons.ZR = src->input0x01.right_trigger > 0;
-        m_buttons.ZL = src->input0x01.left_trigger > 0;
-
-        if (new_format) {
-            m_buttons.dpad_down   = (src->input0x01.buttons.dpad == XboxOneDPad_S)  ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_SE) ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_SW);
-            m_buttons.dpad_up     = (src->input0x01.buttons.dpad == XboxOneDPad_N)  ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_NE) ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_NW);
-            m_buttons.dpad_right  = (src->input0x01.buttons.dpad == XboxOneDPad_E)  ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_NE) ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_SE);
-            m_buttons.dpad_left   = (src->input0x01.buttons.dpad == XboxOneDPad_W)  ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_NW) ||
-                                    (src->input0x01.buttons.dpad == XboxOneDPad_SW);
-
-            m_buttons.A = src->input0x01.buttons.B;
-            m_buttons.B = src->input0x01.buttons.A;
-            m_buttons.X = src->input0x01.buttons.Y;
-            m_buttons.Y = src->input0x01.buttons.X;
-
-            m_buttons.R  = src->input0x01.buttons.RB;
-            m_buttons.L  = src->input0x01.buttons.LB;
-
-            m_buttons.minus = src->input0x01.buttons.view;
-            m_buttons.plus  = src->input0x01.buttons.menu;
-
-            m_buttons.lstick_press = src->input0x01.buttons.lstick_press;
-            m_buttons.rstick_press = src->input0x01.buttons.rstick_press;
-
-            m_buttons.home = src->input0x01.buttons.guide;
-        }
-        else {
-            m_buttons.dpad_down   = (src->input0x01.old.buttons.dpad == XboxOneDPad_S)  ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_SE) ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_SW);
-            m_buttons.dpad_up     = (src->input0x01.old.buttons.dpad == XboxOneDPad_N)  ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_NE) ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_NW);
-            m_buttons.dpad_right  = (src->input0x01.old.buttons.dpad == XboxOneDPad_E)  ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_NE) ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_SE);
-            m_buttons.dpad_left   = (src->input0x01.old.buttons.dpad == XboxOneDPad_W)  ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_NW) ||
-                                    (src->input0x01.old.buttons.dpad == XboxOneDPad_SW);
-
-            m_buttons.A = src->input0x01.old.buttons.B;
-            m_buttons.B = src->input0x01.old.buttons.A;
-            m_buttons.X = src->input0x01.old.buttons.Y;
-            m_buttons.Y = src->input0x01.old.buttons.X;
-
-            m_buttons.R  = src->input0x01.old.buttons.RB;
-            m_buttons.L  = src->input0x01.old.buttons.LB;
-
-            m_buttons.minus = src->input0x01.old.buttons.view;
-            m_buttons.plus  = src->input0x01.old.buttons.menu;
-
-            m_buttons.lstick_press = src->input0x01.old.buttons.lstick_press;
-            m_buttons.rstick_press = src->input0x01.old.buttons.rstick_press;
-        }
+    void XboxOneController::HandleInputReport0x01(const bluetooth::HidReport *report) {
+        if (report->size != sizeof(XboxOneInputReport0x01) + 1)
+            return this->DetectInputReport0x01(report);
+
+        auto src = reinterpret_cast<const XboxOneReportData *>(&report->data);
+        this->MapSticksAndTriggers(&src->input0x01);
+
+        m_buttons.dpad_down   = (src->input0x01.buttons.dpad == XboxOneDPad_S)  ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_SE) ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_SW);
+        m_buttons.dpad_up     = (src->input0x01.buttons.dpad == XboxOneDPad_N)  ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_NE) ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_NW);
+        m_buttons.dpad_right  = (src->input0x01.buttons.dpad == XboxOneDPad_E)  ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_NE) ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_SE);
+        m_buttons.dpad_left   = (src->input0x01.buttons.dpad == XboxOneDPad_W)  ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_NW) ||
+                                (src->input0x01.buttons.dpad == XboxOneDPad_SW);
+
+        m_buttons.A = src->input0x01.buttons.B;
+        m_buttons.B = src->input0x01.buttons.A;
+        m_buttons.X = src->input0x01.buttons.Y;
+        m_buttons.Y = src->input0x01.buttons.X;
+
+        m_buttons.R  = src->input0x01.buttons.RB;
+        m_buttons.L  = src->input0x01.buttons.LB;
+
+        m_buttons.minus = src->input0x01.buttons.view;
+        m_buttons.plus  = src->input0x01.buttons.menu;
+
+        m_buttons.lstick_press = src->input0x01.buttons.lstick_press;
+        m_buttons.rstick_press = src->input0x01.buttons.rstick_press;
+
+        m_buttons.home = src->input0x01.buttons.guide;
+    }
+
+    void XboxOneController::HandleInputReport0x01Old(const bluetooth::HidReport *report) {
+        if (report->size == sizeof(XboxOneInputReport0x01) + 1)
+            return this->DetectInputReport0x01(report);
+
+        auto src = reinterpret_cast<const XboxOneReportData *>(&report->data);
+        this->MapSticksAndTriggers(&src->input0x01);
+
+        m_buttons.dpad_down   = (src->input0x01.old.buttons.dpad == XboxOneDPad_S)  ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_SE) ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_SW);
+        m_buttons.dpad_up     = (src->input0x01.old.buttons.dpad == XboxOneDPad_N)  ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_NE) ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_NW);
+        m_buttons.dpad_right  = (src->input0x01.old.buttons.dpad == XboxOneDPad_E)  ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_NE) ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_SE);
+        m_buttons.dpad_left   = (src->input0x01.old.buttons.dpad == XboxOneDPad_W)  ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_NW) ||
+                                (src->input0x01.old.buttons.dpad == XboxOneDPad_SW);
+
+        m_buttons.A = src->input0x01.old.buttons.B;
+        m_buttons.B = src->input0x01.old.buttons.A;
+        m_buttons.X = src->input0x01.old.buttons.Y;
+        m_buttons.Y = src->input0x01.old.buttons.X;
+
+        m_buttons.R  = src->input0x01.old.buttons.RB;
+        m_buttons.L  = src->input0x01.old.buttons.LB;
+
+        m_buttons.minus = src->input0x01.old.buttons.view;
+        m_buttons.plus  = src->input0x01.old.buttons.menu;
+
+        m_buttons.lstick_press = src->input0x01.old.buttons.lstick_press;
+        m_buttons.rstick_press = src->input0x01.old.buttons.rstick_press;
     }
 
     void XboxOneController::HandleInputReport0x02(const XboxOneReportData *src) {
@@ -139,4 +172,20 @@ namespace ams::controller {
         m_charging = src->input0x04.charging;
     }
 
+    void XboxOneController::MapSticksAndTriggers(const XboxOneInputReport0x01 *src) {
+        m_left_stick.SetData(
+            static_cast<uint16_t>(stick_scale_factor * src->left_stick.x) & 0xfff,
+            static_cast<uint16_t>(stick_scale_factor * (UINT16_MAX - src->left_stick.y)) & 0xfff
+        );
+        m_right_stick.SetData(
+            static_cast<uint16_t>(stick_scale_factor * src->right_stick.x) & 0xfff,
+            static_cast<uint16_t>(stick_scale_factor * (UINT16_MAX - src->right_stick.y)) & 0xfff
+        );
+
+        m_buttons.ZR = src->right_trigger > 0;
+        m_buttons.ZL = src->left_trigger > 0;
+    }
+
+    template class EmulatedSwitchControllerImpl<XboxOneController>;
+
 }
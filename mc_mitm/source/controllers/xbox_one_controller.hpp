@@ -18,6 +18,11 @@
 
 namespace ams::controller {
 
+    enum XboxOneReportFormat : uint8_t {
+        XboxOneReportFormat_Old,    // Older firmware, guide button reported separately in report 0x02
+        XboxOneReportFormat_New
+    };
+
     enum XboxOneDPadDirection {
         XboxOneDPad_Released,
         XboxOneDPad_N,
@@ -126,7 +131,7 @@ namespace ams::controller {
         };
     } __attribute__ ((__packed__));
 
-    class XboxOneController : public EmulatedSwitchController {
+    class XboxOneController : public EmulatedSwitchControllerImpl<XboxOneController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -138,7 +143,11 @@ namespace ams::controller {
             };  
 
             XboxOneController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address)
+                , m_input0x01_handler(&XboxOneController::DetectInputReport0x01)
+                , m_rumble_strong(0)
+                , m_rumble_weak(0)
+                , m_rumble_expiry(0) { };
 
             bool SupportsSetTsiCommand(void) { return false; }
 
@@ -146,10 +155,26 @@ namespace ams::controller {
             void UpdateControllerState(const bluetooth::HidReport *report);
 
         private:
-            void HandleInputReport0x01(const XboxOneReportData *src, bool new_format);
+            void BindReportFormat(XboxOneReportFormat format);
+
+            void DetectInputReport0x01(const bluetooth::HidReport *report);
+            void HandleInputReport0x01(const bluetooth::HidReport *report);
+            void HandleInputReport0x01Old(const bluetooth::HidReport *report);
             void HandleInputReport0x02(const XboxOneReportData *src);
             void HandleInputReport0x04(const XboxOneReportData *src);
 
+            void MapSticksAndTriggers(const XboxOneInputReport0x01 *src);
+
+            // Bound to the handler for the detected format. Each handler only checks the report size, redetecting if the firmware changed
+            void (XboxOneController::*m_input0x01_handler)(const bluetooth::HidReport *report);
+
+            // Last rumble command sent, and when the motors stop unless it is refreshed
+            uint8_t m_rumble_strong;
+            uint8_t m_rumble_weak;
+            os::Tick m_rumble_expiry;
+
     };
 
+    extern template class EmulatedSwitchControllerImpl<XboxOneController>;
+
 }
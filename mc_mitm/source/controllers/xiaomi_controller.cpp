@@ -29,9 +29,11 @@ namespace ams::controller {
 
     Result XiaomiController::Initialize(void) {
         R_TRY(EmulatedSwitchController::Initialize());
+
+        std::scoped_lock lk(s_output_report_lock);
         s_output_report.size = sizeof(init_packet);
         std::memcpy(s_output_report.data, init_packet, sizeof(init_packet));
-        R_TRY(bluetooth::hid::report::SendHidReport(&m_address, &s_output_report));
+        R_TRY(this->SendHidReport(&s_output_report));
         return ams::ResultSuccess();    
     }
     
@@ -91,4 +93,6 @@ namespace ams::controller {
         m_buttons.home     = src->input0x04.home;
     }
 
+    template class EmulatedSwitchControllerImpl<XiaomiController>;
+
 }
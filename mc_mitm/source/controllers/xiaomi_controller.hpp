@@ -81,7 +81,7 @@ namespace ams::controller {
         };
     } __attribute__((packed));
 
-    class XiaomiController : public EmulatedSwitchController {
+    class XiaomiController : public EmulatedSwitchControllerImpl<XiaomiController> {
 
         public:
             static constexpr const HardwareID hardware_ids[] = { 
@@ -89,7 +89,7 @@ namespace ams::controller {
             };  
 
             XiaomiController(const bluetooth::Address *address) 
-                : EmulatedSwitchController(address) { };
+                : EmulatedSwitchControllerImpl(address) { };
 
             Result Initialize(void);
 
@@ -100,4 +100,6 @@ namespace ams::controller {
 
     };
 
+    extern template class EmulatedSwitchControllerImpl<XiaomiController>;
+
 }
@@ -15,24 +15,121 @@
  */
 #include <stratosphere.hpp>
 #include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
 #include "mcmitm_config.hpp"
+#include "controllers/switch_controller.hpp"
 
 namespace ams::mitm {
 
     namespace {
 
         constexpr const char *config_file_location = "sdmc:/config/MissionControl/missioncontrol.ini";
+        constexpr const char *profile_section_prefix = "profile:";
 
-        MissionControlConfig g_global_config = {
+        // The current snapshot, the one controllers are still configured from and one being built
+        constexpr size_t MaxConfigSnapshots = 3;
+
+        struct ButtonName {
+            const char *name;
+            uint32_t mask;
+        };
+
+        constexpr const ButtonName button_names[] = {
+            {"A",           controller::SwitchButton_A},
+            {"B",           controller::SwitchButton_B},
+            {"X",           controller::SwitchButton_X},
+            {"Y",           controller::SwitchButton_Y},
+            {"L",           controller::SwitchButton_L},
+            {"R",           controller::SwitchButton_R},
+            {"ZL",          controller::SwitchButton_ZL},
+            {"ZR",          controller::SwitchButton_ZR},
+            {"MINUS",       controller::SwitchButton_Minus},
+            {"PLUS",        controller::SwitchButton_Plus},
+            {"LSTICK",      controller::SwitchButton_LStick},
+            {"RSTICK",      controller::SwitchButton_RStick},
+            {"HOME",        controller::SwitchButton_Home},
+            {"CAPTURE",     controller::SwitchButton_Capture},
+            {"DPAD_UP",     controller::SwitchButton_DpadUp},
+            {"DPAD_DOWN",   controller::SwitchButton_DpadDown},
+            {"DPAD_LEFT",   controller::SwitchButton_DpadLeft},
+            {"DPAD_RIGHT",  controller::SwitchButton_DpadRight},
+        };
+
+        // The current snapshot holds one reference on behalf of g_current_snapshot. A slot is only rebuilt once its count drops to zero
+        struct ConfigSnapshot {
+            std::atomic<uint32_t> refcount;
+            MissionControlConfig config;
+        };
+
+        os::Mutex g_reload_lock(false);
+        ConfigSnapshot g_snapshots[MaxConfigSnapshots];
+        std::atomic<ConfigSnapshot *> g_current_snapshot;
+
+        const MissionControlConfig g_default_config = {
             .general = {
                 .enable_rumble = true,
                 .enable_motion = true
             },
             .misc = {
-                .disable_sony_leds = false
+                .disable_sony_leds = false,
+                .enable_official_controller_combos = true,
+                .cpu_budget_percent = 50
+            },
+            .profiles = {
+                .entries = {
+                    {
+                        .key = ControllerProfileKey_Default,
+                        .combos = {
+                            // Home combo = MINUS + DPAD_DOWN
+                            {controller::SwitchButton_Minus | controller::SwitchButton_DpadDown, controller::SwitchButton_Home, 0},
+                            // Capture combo = MINUS + DPAD_UP
+                            {controller::SwitchButton_Minus | controller::SwitchButton_DpadUp, controller::SwitchButton_Capture, 0}
+                        },
+                        .num_combos = 2
+                    },
+                    {
+                        // ION iCade Controller
+                        .key = ControllerProfileKey_HardwareId,
+                        .vid = 0x15e4,
+                        .pid = 0x0132,
+                        .combos = {
+                            // Minus combo = ZL + ZR + L
+                            {controller::SwitchButton_ZL | controller::SwitchButton_ZR | controller::SwitchButton_L, controller::SwitchButton_Minus, 0},
+                            // Plus combo = ZL + ZR + R
+                            {controller::SwitchButton_ZL | controller::SwitchButton_ZR | controller::SwitchButton_R, controller::SwitchButton_Plus, 0},
+                            {controller::SwitchButton_Minus | controller::SwitchButton_DpadDown, controller::SwitchButton_Home, 0},
+                            {controller::SwitchButton_Minus | controller::SwitchButton_DpadUp, controller::SwitchButton_Capture, 0}
+                        },
+                        .num_combos = 4
+                    }
+                },
+                .count = 2
             }
         };
 
+        ConfigSnapshot *FindSnapshot(const MissionControlConfig *config) {
+            for (auto &snapshot : g_snapshots) {
+                if (&snapshot.config == config)
+                    return &snapshot;
+            }
+
+            return nullptr;
+        }
+
+        // Claims a slot nobody holds a reference to. A reader racing to acquire a snapshot that has just been replaced may briefly hold a
+        // reference to it, in which case the slot is skipped
+        ConfigSnapshot *ReserveSnapshot(void) {
+            for (auto &snapshot : g_snapshots) {
+                uint32_t expected = 0;
+                if (snapshot.refcount.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+                    return &snapshot;
+            }
+
+            return nullptr;
+        }
+
         void ParseBoolean(const char *value, bool *out) {
             if (strcasecmp(value, "true") == 0)
                 *out = true;
@@ -40,12 +137,12 @@ namespace ams::mitm {
                 *out = false; 
         }
 
-        void ParseBluetoothAddress(const char *value, bluetooth::Address *out) {
+        bool ParseBluetoothAddress(const char *value, bluetooth::Address *out) {
             // Check length of address string is correct
-            if (std::strlen(value) != 3*sizeof(bluetooth::Address) - 1) return;
+            if (std::strlen(value) != 3*sizeof(bluetooth::Address) - 1) return false;
 
             // Parse bluetooth mac address
-            char buf[2 + 1];
+            char buf[2 + 1] = {};
             bluetooth::Address address = {};
             for (uint32_t i = 0; i < sizeof(bluetooth::Address); ++i) {
                 // Convert hex pair to number
@@ -54,10 +151,219 @@ namespace ams::mitm {
 
                 // Check for colon separator
                 if ((i < sizeof(bluetooth::Address) - 1) && (value[i*3 + 2] != ':'))
-                    return;
+                    return false;
             }
 
             *out = address;
+            return true;
+        }
+
+        bool ParseHardwareId(const char *value, uint16_t *vid, uint16_t *pid) {
+            // Expecting vid:pid as a pair of 4 digit hex values
+            if ((std::strlen(value) != 9) || (value[4] != ':')) return false;
+
+            char *end;
+            uint16_t v = static_cast<uint16_t>(std::strtoul(value, &end, 16));
+            if (end != &value[4]) return false;
+
+            uint16_t p = static_cast<uint16_t>(std::strtoul(&value[5], &end, 16));
+            if (*end != '\0') return false;
+
+            *vid = v;
+            *pid = p;
+            return true;
+        }
+
+        void ResetButtonMap(ControllerProfileConfig *profile) {
+            for (size_t i = 0; i < NumSwitchButtonBits; ++i)
+                profile->button_map[i] = BIT(i);
+
+            profile->remap_buttons = false;
+        }
+
+        bool ParseButtonMask(char *value, uint32_t *out) {
+            uint32_t mask = 0;
+
+            char *saveptr;
+            for (auto token = strtok_r(value, " +", &saveptr); token != nullptr; token = strtok_r(nullptr, " +", &saveptr)) {
+                uint32_t button = 0;
+                for (auto b : button_names) {
+                    if (strcasecmp(token, b.name) == 0) {
+                        button = b.mask;
+                        break;
+                    }
+                }
+
+                if (button == 0)
+                    return false;
+
+                mask |= button;
+            }
+
+            if (mask == 0)
+                return false;
+
+            *out = mask;
+            return true;
+        }
+
+        // Combos are specified as <chord>,<output>[,hold_ms] eg. combo=MINUS+DPAD_DOWN,HOME
+        bool ParseButtonCombo(const char *value, ButtonComboConfig *out) {
+            char buf[0x80];
+            std::strncpy(buf, value, sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+
+            char *saveptr;
+            auto chord = strtok_r(buf, ",", &saveptr);
+            auto output = strtok_r(nullptr, ",", &saveptr);
+            auto hold = strtok_r(nullptr, ",", &saveptr);
+
+            ButtonComboConfig combo = {};
+            if (!chord || !output || !ParseButtonMask(chord, &combo.chord) || !ParseButtonMask(output, &combo.output))
+                return false;
+
+            if (hold)
+                combo.hold_ms = std::strtoul(hold, nullptr, 10);
+
+            *out = combo;
+            return true;
+        }
+
+        // Remaps are specified as <button>,<buttons|none> eg. remap=A,B
+        bool ParseButtonRemap(const char *value, ControllerProfileConfig *profile) {
+            char buf[0x80];
+            std::strncpy(buf, value, sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+
+            char *saveptr;
+            auto input = strtok_r(buf, ",", &saveptr);
+            auto output = strtok_r(nullptr, ",", &saveptr);
+
+            uint32_t input_mask;
+            if (!input || !output || !ParseButtonMask(input, &input_mask))
+                return false;
+
+            // Only a single input button can be remapped at a time
+            if ((input_mask & (input_mask - 1)) != 0)
+                return false;
+
+            uint32_t output_mask = 0;
+            while (*output == ' ')
+                ++output;
+
+            if ((strcasecmp(output, "none") != 0) && !ParseButtonMask(output, &output_mask))
+                return false;
+
+            profile->button_map[__builtin_ctz(input_mask)] = output_mask;
+            profile->remap_buttons = true;
+            return true;
+        }
+
+        // Keyboard keys are mapped in the form <usage>,<hold|press|release|none>[,<buttons>] eg. keymap=0x2c,hold,A
+        bool ParseKeyboardKeyMapping(const char *value, ControllerProfileConfig *profile) {
+            char buf[0x80];
+            std::strncpy(buf, value, sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+
+            char *saveptr;
+            auto usage = strtok_r(buf, ",", &saveptr);
+            auto action = strtok_r(nullptr, ",", &saveptr);
+            auto output = strtok_r(nullptr, ",", &saveptr);
+            if (!usage || !action)
+                return false;
+
+            char *end;
+            auto key = std::strtoul(usage, &end, 0);
+            if ((end == usage) || (key >= NumKeyboardKeycodes))
+                return false;
+
+            while (*action == ' ')
+                ++action;
+
+            KeyboardKeyMapping mapping = {};
+            if (strcasecmp(action, "none") == 0)
+                mapping.action = KeyboardKeyAction_None;
+            else if (strcasecmp(action, "hold") == 0)
+                mapping.action = KeyboardKeyAction_Hold;
+            else if (strcasecmp(action, "press") == 0)
+                mapping.action = KeyboardKeyAction_Press;
+            else if (strcasecmp(action, "release") == 0)
+                mapping.action = KeyboardKeyAction_Release;
+            else
+                return false;
+
+            if (mapping.action != KeyboardKeyAction_None) {
+                uint32_t buttons;
+                if (!output || !ParseButtonMask(output, &buttons))
+                    return false;
+
+                mapping.buttons = buttons;
+            }
+
+            // A key mapped again replaces its earlier mapping
+            for (size_t i = 0; i < profile->num_keymaps; ++i) {
+                if (profile->keymap[i].key == key) {
+                    profile->keymap[i].mapping = mapping;
+                    return true;
+                }
+            }
+
+            if (profile->num_keymaps >= MaxKeyboardKeyMappings)
+                return false;
+
+            profile->keymap[profile->num_keymaps++] = {static_cast<uint8_t>(key), mapping};
+            return true;
+        }
+
+        ControllerProfileConfig *GetSectionProfile(MissionControlConfig *config, const char *key) {
+            ControllerProfileConfig profile = {};
+            if (strcasecmp(key, "default") == 0)
+                profile.key = ControllerProfileKey_Default;
+            else if (ParseHardwareId(key, &profile.vid, &profile.pid))
+                profile.key = ControllerProfileKey_HardwareId;
+            else if (ParseBluetoothAddress(key, &profile.address))
+                profile.key = ControllerProfileKey_Address;
+            else
+                return nullptr;
+
+            for (size_t i = 0; i < config->profiles.count; ++i) {
+                auto entry = &config->profiles.entries[i];
+                if (entry->key != profile.key)
+                    continue;
+
+                if ((profile.key == ControllerProfileKey_HardwareId) && ((entry->vid != profile.vid) || (entry->pid != profile.pid)))
+                    continue;
+
+                if ((profile.key == ControllerProfileKey_Address) && (std::memcmp(&entry->address, &profile.address, sizeof(bluetooth::Address)) != 0))
+                    continue;
+
+                // User profiles replace built-in defaults, other than keeping their combos until the section lists its own
+                if (!entry->user_defined) {
+                    std::memcpy(profile.combos, entry->combos, sizeof(profile.combos));
+                    profile.num_combos = entry->num_combos;
+
+                    *entry = profile;
+                    entry->user_defined = true;
+                    ResetButtonMap(entry);
+                }
+
+                return entry;
+            }
+
+            if (config->profiles.count >= MaxControllerProfiles)
+                return nullptr;
+
+            // New profiles start out with the built-in default combos
+            auto defaults = &g_default_config.profiles.entries[0];
+            std::memcpy(profile.combos, defaults->combos, sizeof(profile.combos));
+            profile.num_combos = defaults->num_combos;
+
+            auto entry = &config->profiles.entries[config->profiles.count++];
+            *entry = profile;
+            entry->user_defined = true;
+            ResetButtonMap(entry);
+
+            return entry;
         }
 
         int ConfigIniHandler(void *user, const char *section, const char *name, const char *value) {
@@ -71,13 +377,50 @@ namespace ams::mitm {
             }
             else if (strcasecmp(section, "bluetooth") == 0) {
                 if (strcasecmp(name, "host_name") == 0)
-                    std::strncpy(config->bluetooth.host_name, value, sizeof(config->bluetooth.host_name));
+                    std::strncpy(config->bluetooth.host_name, value, sizeof(config->bluetooth.host_name) - 1);
                 else if (strcasecmp(name, "host_address") == 0)
                     ParseBluetoothAddress(value, &config->bluetooth.host_address);
+                else if (strcasecmp(name, "filter_inquiry_results") == 0)
+                    ParseBoolean(value, &config->bluetooth.filter_inquiry_results);
             }
             else if (strcasecmp(section, "misc") == 0) {
                 if (strcasecmp(name, "disable_sony_leds") == 0)
                     ParseBoolean(value, &config->misc.disable_sony_leds);
+                else if (strcasecmp(name, "enable_official_controller_combos") == 0)
+                    ParseBoolean(value, &config->misc.enable_official_controller_combos);
+                else if (strcasecmp(name, "cpu_budget_percent") == 0)
+                    config->misc.cpu_budget_percent = std::min<uint32_t>(std::strtoul(value, nullptr, 10), 100);
+            }
+            else if (strncasecmp(section, profile_section_prefix, std::strlen(profile_section_prefix)) == 0) {
+                auto profile = GetSectionProfile(config, &section[std::strlen(profile_section_prefix)]);
+                if (!profile)
+                    return 0;
+
+                if (strcasecmp(name, "combo") == 0) {
+                    // The first combo listed replaces any built-in ones
+                    if (!profile->user_combos) {
+                        profile->num_combos = 0;
+                        profile->user_combos = true;
+                    }
+
+                    if ((profile->num_combos < MaxButtonCombos) && ParseButtonCombo(value, &profile->combos[profile->num_combos]))
+                        ++profile->num_combos;
+                }
+                else if (strcasecmp(name, "remap") == 0) {
+                    ParseButtonRemap(value, profile);
+                }
+                else if (strcasecmp(name, "pacing_interval_ms") == 0) {
+                    profile->pacing_interval_ms = std::strtoul(value, nullptr, 10);
+                }
+                else if (strcasecmp(name, "report_interval_ms") == 0) {
+                    profile->report_interval_ms = std::strtoul(value, nullptr, 10);
+                }
+                else if (strcasecmp(name, "tsi_pacing") == 0) {
+                    ParseBoolean(value, &profile->tsi_pacing);
+                }
+                else if (strcasecmp(name, "keymap") == 0) {
+                    ParseKeyboardKeyMapping(value, profile);
+                }
             }
             else {
                 return 0;
@@ -86,30 +429,96 @@ namespace ams::mitm {
             return 1;
         }
 
-    }
+        void ParseIniConfig(MissionControlConfig *config) {
+            const char *mount_name = "sdmc";
+            if (R_FAILED(fs::MountSdCard(mount_name))) {
+                return;
+            }
+            ON_SCOPE_EXIT { fs::Unmount(mount_name); };
+
+            /* Open the file. */
+            fs::FileHandle file;
+            {
+                if (R_FAILED(fs::OpenFile(std::addressof(file), config_file_location, fs::OpenMode_Read))) {
+                    return;
+                }
+            }
+            ON_SCOPE_EXIT { fs::CloseFile(file); };
+
+            /* Parse the config. */
+            util::ini::ParseFile(file, config, ConfigIniHandler);
+        }
 
-    MissionControlConfig *GetGlobalConfig(void) {
-        return &g_global_config;
     }
 
-    void ParseIniConfig(void) {
-        const char *mount_name = "sdmc";
-        if (R_FAILED(fs::MountSdCard(mount_name))) {
-            return;
+    const MissionControlConfig *AcquireConfig(void) {
+        while (true) {
+            auto snapshot = g_current_snapshot.load(std::memory_order_acquire);
+            snapshot->refcount.fetch_add(1, std::memory_order_acquire);
+
+            // If a reload replaced the snapshot before the reference was taken, its slot may already be being rebuilt
+            if (g_current_snapshot.load(std::memory_order_acquire) == snapshot)
+                return &snapshot->config;
+
+            snapshot->refcount.fetch_sub(1, std::memory_order_release);
         }
-        ON_SCOPE_EXIT { fs::Unmount(mount_name); };
+    }
 
-        /* Open the file. */
-        fs::FileHandle file;
-        {
-            if (R_FAILED(fs::OpenFile(std::addressof(file), config_file_location, fs::OpenMode_Read))) {
-                return;
+    void ReleaseConfig(const MissionControlConfig *config) {
+        auto snapshot = FindSnapshot(config);
+        AMS_ABORT_UNLESS(snapshot);
+
+        auto previous = snapshot->refcount.fetch_sub(1, std::memory_order_release);
+        AMS_ABORT_UNLESS(previous > 0);
+    }
+
+    bool IsCurrentConfig(const MissionControlConfig *config) {
+        return &g_current_snapshot.load(std::memory_order_relaxed)->config == config;
+    }
+
+    const ControllerProfileConfig *FindControllerProfile(const MissionControlConfig *config, const bluetooth::Address *address, uint16_t vid, uint16_t pid) {
+        const ControllerProfileConfig *default_profile = nullptr;
+        const ControllerProfileConfig *hwid_profile = nullptr;
+
+        // Address profiles take precedence over hardware id profiles, which take precedence over the default
+        for (size_t i = 0; i < config->profiles.count; ++i) {
+            auto entry = &config->profiles.entries[i];
+            switch (entry->key) {
+                case ControllerProfileKey_Address:
+                    if (std::memcmp(&entry->address, address, sizeof(bluetooth::Address)) == 0)
+                        return entry;
+                    break;
+                case ControllerProfileKey_HardwareId:
+                    if ((entry->vid == vid) && (entry->pid == pid))
+                        hwid_profile = entry;
+                    break;
+                default:
+                    default_profile = entry;
+                    break;
             }
         }
-        ON_SCOPE_EXIT { fs::CloseFile(file); };
 
-        /* Parse the config. */
-        util::ini::ParseFile(file, &g_global_config, ConfigIniHandler);
+        return hwid_profile ? hwid_profile : default_profile;
+    }
+
+    Result ReloadConfig(void) {
+        std::scoped_lock lk(g_reload_lock);
+
+        // The slot comes with the reference that will be held on behalf of g_current_snapshot. With every slot still referenced, the caller
+        // can retry once controllers have moved on to the current snapshot
+        auto snapshot = ReserveSnapshot();
+        if (!snapshot)
+            return os::ResultBusy();
+
+        // The slot isn't current, so it can be filled in without blocking controllers acquiring or releasing the config
+        snapshot->config = g_default_config;
+        ParseIniConfig(&snapshot->config);
+
+        auto previous = g_current_snapshot.exchange(snapshot, std::memory_order_acq_rel);
+        if (previous)
+            previous->refcount.fetch_sub(1, std::memory_order_release);
+
+        return ams::ResultSuccess();
     }
 
 }
@@ -13,10 +13,70 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#pragma once
 #include "bluetooth_mitm/bluetooth/bluetooth_types.hpp"
 
 namespace ams::mitm {
 
+    constexpr size_t MaxControllerProfiles = 8;
+    constexpr size_t MaxButtonCombos = 8;
+    constexpr size_t NumSwitchButtonBits = 24;
+    constexpr size_t NumKeyboardKeycodes = 0x100;
+    constexpr size_t MaxKeyboardKeyMappings = 32;
+
+    enum ControllerProfileKey {
+        ControllerProfileKey_Default,
+        ControllerProfileKey_HardwareId,
+        ControllerProfileKey_Address,
+    };
+
+    struct ButtonComboConfig {
+        uint32_t chord;     // Buttons that must be held together to trigger the combo
+        uint32_t output;    // Buttons reported in place of the chord
+        uint32_t hold_ms;   // Time the chord must be held before triggering
+    };
+
+    enum KeyboardKeyAction : uint8_t {
+        KeyboardKeyAction_None,     // Key is ignored
+        KeyboardKeyAction_Hold,     // Buttons are held while the key is down
+        KeyboardKeyAction_Press,    // Buttons are latched on when the key goes down
+        KeyboardKeyAction_Release,  // Buttons are latched off when the key goes down
+    };
+
+    struct KeyboardKeyMapping {
+        uint32_t buttons : 24;
+        uint32_t action  : 8;
+    };
+
+    struct KeyboardKeyBinding {
+        uint8_t key;    // Keyboard usage id
+        KeyboardKeyMapping mapping;
+    };
+
+    struct ControllerProfileConfig {
+        ControllerProfileKey key;
+        uint16_t vid;
+        uint16_t pid;
+        ams::bluetooth::Address address;
+        bool user_defined;
+
+        ButtonComboConfig combos[MaxButtonCombos];
+        size_t num_combos;
+        bool user_combos;   // Set once the profile's section lists combos, replacing the built-in ones
+
+        // Output mask for each button bit, compiled into per-byte lookup tables when a controller is configured with the profile
+        uint32_t button_map[NumSwitchButtonBits];
+        bool remap_buttons;
+
+        uint32_t pacing_interval_ms;
+        uint32_t report_interval_ms;    // Requested from Sony controllers. 0 selects the controller's default
+        bool tsi_pacing;                // Pace reports to the tsi requested by the console
+
+        // Only keys the profile overrides are stored, keys not listed keep the controller's own mapping
+        KeyboardKeyBinding keymap[MaxKeyboardKeyMappings];
+        size_t num_keymaps;
+    };
+
     struct MissionControlConfig {
         struct {
             bool enable_rumble;
@@ -25,15 +85,61 @@ namespace ams::mitm {
 
         struct {
             char host_name[0x20];
-            bluetooth::Address host_address;
+            ams::bluetooth::Address host_address;
+            bool filter_inquiry_results;
         } bluetooth;
 
         struct {
             bool disable_sony_leds;
+            bool enable_official_controller_combos;
+            uint32_t cpu_budget_percent;
         } misc;
+
+        struct {
+            ControllerProfileConfig entries[MaxControllerProfiles];
+            size_t count;
+        } profiles;
+    };
+
+    // Parsed configs are immutable snapshots. Reloading publishes a new one with a single pointer swap, and the
+    // previous snapshot is reused once every reference to it has been released
+    const MissionControlConfig *AcquireConfig(void);
+    void ReleaseConfig(const MissionControlConfig *config);
+    bool IsCurrentConfig(const MissionControlConfig *config);
+
+    // Reference to the current snapshot owned by a single thread, swapped only when a reload has published a newer one. Reading the config
+    // through it costs one pointer comparison, with no reference counting per access. Each thread reading the config on a hot path keeps its own
+    class CachedConfig {
+
+        public:
+            constexpr CachedConfig(void) : m_config(nullptr) { }
+
+            ~CachedConfig(void) {
+                if (m_config)
+                    ReleaseConfig(m_config);
+            }
+
+            CachedConfig(const CachedConfig &) = delete;
+            CachedConfig &operator=(const CachedConfig &) = delete;
+
+            // The returned snapshot stays valid until the next call
+            const MissionControlConfig *Get(void) {
+                if (!m_config || !IsCurrentConfig(m_config)) {
+                    auto config = AcquireConfig();
+                    if (m_config)
+                        ReleaseConfig(m_config);
+
+                    m_config = config;
+                }
+
+                return m_config;
+            }
+
+        private:
+            const MissionControlConfig *m_config;
     };
 
-    MissionControlConfig *GetGlobalConfig(void);
-    void ParseIniConfig(void);
+    const ControllerProfileConfig *FindControllerProfile(const MissionControlConfig *config, const ams::bluetooth::Address *address, uint16_t vid, uint16_t pid);
+    Result ReloadConfig(void);
 
 }
@@ -17,26 +17,43 @@
 #include <switch.h>
 #include "mcmitm_initialization.hpp"
 #include "mcmitm_config.hpp"
+#include "mcmitm_utils.hpp"
 #include "bluetooth_mitm/btdrv_mitm_service.hpp"
 #include "bluetooth_mitm/bluetoothmitm_module.hpp"
 #include "btm_mitm/btmmitm_module.hpp"
 #include "bluetooth_mitm/bluetooth/bluetooth_events.hpp"
 #include "bluetooth_mitm/bluetooth/bluetooth_core.hpp"
+#include "bluetooth_mitm/bluetooth/bluetooth_adapter.hpp"
 #include "bluetooth_mitm/bluetooth/bluetooth_hid.hpp"
 #include "bluetooth_mitm/bluetooth/bluetooth_ble.hpp"
+#include "controllers/controller_state_feed.hpp"
+#include "controllers/controller_identity_cache.hpp"
+#include <atomic>
  
 namespace ams::mitm {
 
     namespace {
 
-        constexpr size_t InitializeThreadStackSize = 0x1000;
+        constexpr size_t InitializeThreadStackSize = 0x2000;
 
         os::ThreadType g_initialize_thread;
         alignas(os::ThreadStackAlignment) u8 g_initialize_thread_stack[InitializeThreadStackSize];
 
         os::Event g_init_event(os::EventClearMode_ManualClear);
 
+        std::atomic<s64> g_boot_phase_ticks[BootPhase_Count];
+
         void InitializeThreadFunc(void *arg) {
+            // Parse global module settings ini from sd card while the mitm servers are being registered
+            R_ABORT_UNLESS(ReloadConfig());
+            RecordBootPhase(BootPhase_ConfigParsed);
+
+            // Create shared memory for publishing controller state to other processes
+            R_ABORT_UNLESS(ams::controller::InitializeStateFeed());
+
+            // Load the identities of previously connected devices from sd card
+            R_ABORT_UNLESS(ams::controller::InitializeIdentityCache());
+
             // Start bluetooth event handling thread
             ams::bluetooth::events::Initialize();
 
@@ -46,44 +63,54 @@ namespace ams::mitm {
             // Connect to btdrv service now that we're sure the mitm is up and running
             R_ABORT_UNLESS(btdrvInitialize());
 
+            // Cache the adapter properties so they don't need to be fetched during pairing
+            R_ABORT_UNLESS(ams::bluetooth::adapter::Initialize());
+
             // Get global module settings
-            auto config = GetGlobalConfig();
+            auto config = AcquireConfig();
+            ON_SCOPE_EXIT { ReleaseConfig(config); };
 
-            // Set bluetooth adapter host address override
+            // Set bluetooth adapter host address override, skipping the btdrv call if the adapter already has it
             ams::bluetooth::Address null_address = {};
             if (std::memcmp(&config->bluetooth.host_address, &null_address, sizeof(ams::bluetooth::Address)) != 0) {
-                if (hos::GetVersion() < hos::Version_12_0_0) {
-                    R_ABORT_UNLESS(btdrvLegacySetAdapterProperty(BtdrvBluetoothPropertyType_Address, &config->bluetooth.host_address, sizeof(ams::bluetooth::Address)));
-                }
-                else {
-                    BtdrvAdapterProperty property;
-                    property.type = BtdrvAdapterPropertyType_Address;
-                    property.size = sizeof(ams::bluetooth::Address);
-                    std::memcpy(property.data, &config->bluetooth.host_address, sizeof(ams::bluetooth::Address));
-                    R_ABORT_UNLESS(btdrvSetAdapterProperty(BtdrvAdapterPropertyType_Address, &property));
-                }
+                ams::bluetooth::Address address;
+                ams::bluetooth::adapter::GetAddress(&address);
+                if (std::memcmp(&address, &config->bluetooth.host_address, sizeof(ams::bluetooth::Address)) != 0)
+                    R_ABORT_UNLESS(ams::bluetooth::adapter::SetAddress(&config->bluetooth.host_address));
             }
 
-            // Set bluetooth adapter host name override
+            // Set bluetooth adapter host name override, likewise only if it differs
             if (std::strlen(config->bluetooth.host_name) > 0) {
-                if (hos::GetVersion() < hos::Version_12_0_0) {
-                    R_ABORT_UNLESS(btdrvLegacySetAdapterProperty(BtdrvBluetoothPropertyType_Name, config->bluetooth.host_name, std::strlen(config->bluetooth.host_name)));
-                }
-                else {
-                    BtdrvAdapterProperty property;
-                    property.type = BtdrvAdapterPropertyType_Name;
-                    property.size = std::strlen(config->bluetooth.host_name);
-                    std::memcpy(property.data, config->bluetooth.host_name, std::strlen(config->bluetooth.host_name));
-                    R_ABORT_UNLESS(btdrvSetAdapterProperty(BtdrvAdapterPropertyType_Name, &property));
-                }
+                char name[ams::bluetooth::adapter::MaxNameLength + 1];
+                ams::bluetooth::adapter::GetName(name, sizeof(name));
+                if (std::strcmp(name, config->bluetooth.host_name) != 0)
+                    R_ABORT_UNLESS(ams::bluetooth::adapter::SetName(config->bluetooth.host_name));
             }
 
+            RecordBootPhase(BootPhase_AdapterConfigured);
+
             g_init_event.Signal();
         }
 
     }
 
+    void RecordBootPhase(BootPhase phase) {
+        // Only the first time a phase is reached is of interest
+        s64 expected = 0;
+        g_boot_phase_ticks[phase].compare_exchange_strong(expected, os::GetSystemTick().GetInt64Value(), std::memory_order_relaxed);
+    }
+
+    void GetBootTimestamps(BootTimestamps *out) {
+        auto start = g_boot_phase_ticks[BootPhase_ProcessStart].load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < BootPhase_Count; ++i) {
+            auto tick = g_boot_phase_ticks[i].load(std::memory_order_relaxed);
+            out->phases[i] = tick ? os::ConvertToTimeSpan(os::Tick(tick - start)).GetNanoSeconds() : 0;
+        }
+    }
+
     void StartInitialize(void) {
+        utils::PaintThreadStack("initialize", g_initialize_thread_stack, sizeof(g_initialize_thread_stack));
         R_ABORT_UNLESS(os::CreateThread(&g_initialize_thread, 
             InitializeThreadFunc, 
             nullptr, 
@@ -102,6 +129,8 @@ namespace ams::mitm {
     void LaunchModules(void) {
         R_ABORT_UNLESS(ams::mitm::bluetooth::Launch());
         R_ABORT_UNLESS(ams::mitm::btm::Launch());
+
+        RecordBootPhase(BootPhase_ModulesLaunched);
     }
 
     void WaitModules(void) {
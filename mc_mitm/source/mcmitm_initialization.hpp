@@ -14,9 +14,29 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #pragma once
+#include <switch.h>
 
 namespace ams::mitm {
 
+    enum BootPhase {
+        BootPhase_ProcessStart,
+        BootPhase_ConfigParsed,
+        BootPhase_ModulesLaunched,
+        BootPhase_BluetoothEnabled,
+        BootPhase_AdapterConfigured,
+        BootPhase_FirstControllerAttached,
+
+        BootPhase_Count
+    };
+
+    // Nanoseconds from process start until each phase was first reached, or 0 if it hasn't been yet
+    struct BootTimestamps {
+        u64 phases[BootPhase_Count];
+    };
+
+    void RecordBootPhase(BootPhase phase);
+    void GetBootTimestamps(BootTimestamps *out);
+
     void StartInitialize(void);
     void WaitInitialized(void);
     void LaunchModules(void);
@@ -16,7 +16,6 @@
 #include <switch.h>
 #include <stratosphere.hpp>
 #include "mcmitm_initialization.hpp"
-#include "mcmitm_config.hpp"
 
 extern "C" {
 
@@ -65,6 +64,8 @@ void __libnx_initheap(void) {
 }
 
 void __appInit(void) {
+    ams::mitm::RecordBootPhase(ams::mitm::BootPhase_ProcessStart);
+
     hos::InitializeForStratosphere();
 
     R_ABORT_UNLESS(smInitialize());
@@ -86,9 +87,6 @@ void __libnx_exception_handler(ThreadExceptionDump* ctx) {
 }
 
 int main(int argc, char **argv) {
-    // Parse global module settings ini from sd card
-    ams::mitm::ParseIniConfig();
-
     // Start initialisation thread
     ams::mitm::StartInitialize();
 
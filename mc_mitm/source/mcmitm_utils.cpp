@@ -14,6 +14,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "mcmitm_utils.hpp"
+#include <mutex>
+#include <cstring>
 
 namespace ams::mitm::utils {
 
@@ -24,6 +26,27 @@ namespace ams::mitm::utils {
         constexpr inline s32 HighestTargetThreadPriority = 0;
         constexpr inline s32 LowestTargetThreadPriority = TargetThreadPriorityRangeSize - 1;
 
+        constexpr u8 StackPaintPattern = 0xcd;
+
+        struct TrackedStack {
+            const char *name;
+            const u8 *stack;
+            size_t size;
+        };
+
+        os::Mutex g_stack_lock(false);
+        TrackedStack g_tracked_stacks[MaxTrackedThreadStacks];
+        size_t g_tracked_stack_count;
+
+        size_t MeasureStackUsage(const TrackedStack *tracked) {
+            // Stacks grow down, so untouched pattern bytes accumulate from the lowest address
+            size_t unused = 0;
+            while ((unused < tracked->size) && (tracked->stack[unused] == StackPaintPattern))
+                ++unused;
+
+            return tracked->size - unused;
+        }
+
     }
 
     s32 ConvertToHorizonPriority(s32 user_priority) {
@@ -37,4 +60,28 @@ namespace ams::mitm::utils {
         return horizon_priority - UserThreadPriorityOffset;
     }
 
+    void PaintThreadStack(const char *name, void *stack, size_t size) {
+        std::memset(stack, StackPaintPattern, size);
+
+        std::scoped_lock lk(g_stack_lock);
+        if (g_tracked_stack_count < MaxTrackedThreadStacks)
+            g_tracked_stacks[g_tracked_stack_count++] = {name, static_cast<const u8 *>(stack), size};
+    }
+
+    size_t GetThreadStackUsage(ThreadStackUsage *usage, size_t max_count) {
+        std::scoped_lock lk(g_stack_lock);
+
+        size_t count = 0;
+        for (; (count < g_tracked_stack_count) && (count < max_count); ++count) {
+            auto tracked = &g_tracked_stacks[count];
+
+            usage[count] = {};
+            std::strncpy(usage[count].name, tracked->name, sizeof(usage[count].name) - 1);
+            usage[count].size = tracked->size;
+            usage[count].high_water_mark = MeasureStackUsage(tracked);
+        }
+
+        return count;
+    }
+
 }
@@ -20,4 +20,16 @@ namespace ams::mitm::utils {
     s32 ConvertToHorizonPriority(s32 user_priority);
     s32 ConvertToUserPriority(s32 horizon_priority);
 
+    constexpr size_t MaxTrackedThreadStacks = 8;
+
+    struct ThreadStackUsage {
+        char name[0x10];
+        u32 size;
+        u32 high_water_mark;    // Deepest the stack has been used since the thread was created
+    };
+
+    // Fills a stack with a known pattern before its thread is started, so peak usage can be measured later on
+    void PaintThreadStack(const char *name, void *stack, size_t size);
+    size_t GetThreadStackUsage(ThreadStackUsage *usage, size_t max_count);
+
 }